@@ -0,0 +1,205 @@
+#!/bin/sh
+# Runs the examples through each backend a few times and reports the front
+# end, compile and run times (the median over all trials, in milliseconds)
+# along with how many opcodes per second each backend got through.
+#
+# Usage: bench.sh [-x brainfuck] [-n trials] [-f csv|json] [-e examples]
+#                 [-b backends] [-c baseline.csv] [-t percent]
+#
+# The backends are `interpret`, `tiered`, `jit` (-r), `template` (-j), `c`
+# (-c, built with $CC -O2) and `native` (-o).  Save the CSV output of one run
+# and pass it to -c on a later one to have every run time that got more than
+# -t percent (10 by default) slower reported; the exit status is then 1.
+#
+# Every run is made with -E, so that no part of an example is evaluated while
+# it is compiled and every backend runs all of it.
+
+BRAINFUCK=./brainfuck
+TRIALS=3
+FORMAT=csv
+EXAMPLES="bench mandel hanoi long"
+BACKENDS="interpret tiered jit template c native"
+BASELINE=
+THRESHOLD=10
+
+while getopts "x:n:f:e:b:c:t:" option; do
+    case $option in
+    x) BRAINFUCK=$OPTARG ;;
+    n) TRIALS=$OPTARG ;;
+    f) FORMAT=$OPTARG ;;
+    e) EXAMPLES=$OPTARG ;;
+    b) BACKENDS=$OPTARG ;;
+    c) BASELINE=$OPTARG ;;
+    t) THRESHOLD=$OPTARG ;;
+    *) sed -n 's/^# \{0,1\}//p' "$0" | sed -n '/^Usage/,/^$/p' >&2; exit 2 ;;
+    esac
+done
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+WORK=$(mktemp -d)
+RESULTS=$WORK/results.csv
+
+trap 'rm -rf "$WORK"' EXIT
+
+now() {
+    date +%s%N
+}
+
+# Prints the number after the given words in the statistics of a run.
+statistic() {
+    sed -n "s/.*$1 \([0-9.]*\).*/\1/p" "$WORK/statistics" | tail -n 1
+}
+
+median() {
+    tr ' ' '\n' | sed '/^$/d' | sort -n |
+        awk '{ v[NR] = $1 } END { print (NR ? v[int((NR + 1) / 2)] : 0) }'
+}
+
+elapsed() {
+    echo "$1 $2" | awk '{ printf "%.3f", ($2 - $1) / 1e6 }'
+}
+
+# One trial, leaving the front end, compile and run times in milliseconds in
+# FRONTEND, COMPILE and RUN.
+run_trial() {
+    example=$1
+    backend=$2
+
+    FRONTEND=0
+    COMPILE=0
+
+    case $backend in
+    interpret | tiered)
+        engine=compact
+        [ "$backend" = tiered ] && engine=tiered
+
+        start=$(now)
+        "$BRAINFUCK" -s -E -i "$engine" "$example" </dev/null >/dev/null \
+            2>"$WORK/statistics" || return 1
+        total=$(elapsed "$start" "$(now)")
+
+        FRONTEND=$(statistic "opcodes in")
+        ;;
+
+    jit | template)
+        flag=-r
+        [ "$backend" = template ] && flag=-j
+
+        start=$(now)
+        "$BRAINFUCK" -s -E -x "$flag" "$example" </dev/null >/dev/null \
+            2>"$WORK/statistics" || return 1
+        total=$(elapsed "$start" "$(now)")
+
+        FRONTEND=$(statistic "opcodes in")
+        COMPILE=$(statistic "compiled in")
+        [ "$backend" = template ] && COMPILE=$(statistic "assembled in")
+        ;;
+
+    c | native)
+        start=$(now)
+
+        if [ "$backend" = c ]; then
+            "$BRAINFUCK" -s -E -x -c "$WORK/program.c" "$example" </dev/null \
+                >/dev/null 2>"$WORK/statistics" &&
+                ${CC:-cc} -O2 -w -o "$WORK/program" "$WORK/program.c" ||
+                return 1
+        else
+            "$BRAINFUCK" -s -E -x -o "$WORK/program" "$example" </dev/null \
+                >/dev/null 2>"$WORK/statistics" || return 1
+        fi
+
+        middle=$(now)
+        "$WORK/program" </dev/null >/dev/null || return 1
+        end=$(now)
+
+        FRONTEND=$(statistic "opcodes in")
+        COMPILE=$(elapsed "$start" "$middle")
+        COMPILE=$(echo "$COMPILE $FRONTEND" | awk '{ printf "%.3f", $1 - $2 }')
+        RUN=$(elapsed "$middle" "$end")
+
+        return 0
+        ;;
+
+    *)
+        echo "bench: unknown backend \`$backend'" >&2
+        exit 2
+        ;;
+    esac
+
+    RUN=$(echo "$total $FRONTEND $COMPILE" |
+        awk '{ r = $1 - $2 - $3; printf "%.3f", (r > 0 ? r : 0) }')
+}
+
+echo "example,backend,trials,frontend_ms,compile_ms,run_ms,opcodes,mops" \
+    >"$RESULTS"
+
+for name in $EXAMPLES; do
+    example=$ROOT/examples/$name.b
+
+    # The switch interpreter counts the opcodes it runs; every backend runs
+    # the same ones.
+    "$BRAINFUCK" -s -E -i switch "$example" </dev/null >/dev/null \
+        2>"$WORK/statistics"
+    opcodes=$(statistic "executed")
+
+    for backend in $BACKENDS; do
+        frontends=
+        compiles=
+        runs=
+        trial=0
+
+        while [ "$trial" -lt "$TRIALS" ]; do
+            if ! run_trial "$example" "$backend"; then
+                echo "bench: $name failed on $backend" >&2
+                exit 1
+            fi
+
+            frontends="$frontends $FRONTEND"
+            compiles="$compiles $COMPILE"
+            runs="$runs $RUN"
+
+            trial=$((trial + 1))
+        done
+
+        frontend=$(echo "$frontends" | median)
+        compile=$(echo "$compiles" | median)
+        run=$(echo "$runs" | median)
+
+        echo "$name $backend $TRIALS $frontend $compile $run ${opcodes:-0}" |
+            awk '{ printf "%s,%s,%d,%.3f,%.3f,%.3f,%s,%.1f\n", $1, $2, $3,
+                $4, $5, $6, $7, ($6 > 0 ? $7 / $6 / 1e3 : 0) }' >>"$RESULTS"
+    done
+done
+
+if [ "$FORMAT" = json ]; then
+    awk -F, 'NR == 1 { for (i = 1; i <= NF; ++i) key[i] = $i; next }
+        {
+            printf "%s\n  {", (NR == 2 ? "[" : ",")
+            for (i = 1; i <= NF; ++i) {
+                value = i <= 2 ? "\"" $i "\"" : $i
+                printf "%s\"%s\": %s", (i > 1 ? ", " : ""), key[i], value
+            }
+            printf "}"
+        }
+        END { print (NR > 1 ? "\n]" : "[]") }' "$RESULTS"
+else
+    cat "$RESULTS"
+fi
+
+if [ -n "$BASELINE" ]; then
+    awk -F, -v threshold="$THRESHOLD" '
+        NR == FNR { if (FNR > 1) baseline[$1 "," $2] = $6; next }
+        FNR > 1 && ($1 "," $2) in baseline {
+            before = baseline[$1 "," $2]
+            change = before > 0 ? ($6 - before) / before * 100 : 0
+
+            printf "%-10s %-10s %10.3f ms -> %10.3f ms %+7.1f%%%s\n", $1, $2,
+                before, $6, change, (change > threshold ? "  regressed" : "") \
+                > "/dev/stderr"
+
+            if (change > threshold) {
+                regressions++
+            }
+        }
+        END { exit (regressions > 0) }' "$BASELINE" "$RESULTS" || exit 1
+fi
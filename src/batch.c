@@ -0,0 +1,712 @@
+/*
+ *  dP                         oo          .8888b                   dP
+ *  88                                     88   "                   88
+ *  88d888b. 88d888b. .d8888b. dP 88d888b. 88aaa  dP    dP .d8888b. 88  .dP
+ *  88'  `88 88'  `88 88'  `88 88 88'  `88 88     88    88 88'  `"" 88888"
+ *  88.  .88 88       88.  .88 88 88    88 88     88.  .88 88.  ... 88  `8b.
+ *  88Y8888' dP       `88888P8 dP dP    dP dP     `88888P' `88888P' dP   `YP
+ *
+ * Authored in 2013.  See README for a list of contributors.
+ * Released into the public domain.
+ *
+ * Any being (not just humans) is free to copy, modify, publish, use, compile,
+ * sell or distribute this software, either in source code form or as a
+ * compiled binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain.  We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors.  We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * The software is provided AS IS, without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose and non-infringement.  In no event shall
+ * the authors be liable for any claim, damages or other liability, whether in
+ * an action of contract, tort or otherwise, arising from, out of or in
+ * connection with the software or the use or other dealings in the software.
+ *
+ * This software is completely unlicensed. */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "batch.h"
+
+#define B_TRUE 1
+#define B_FALSE 0
+
+/* The pool.  Every worker owns a deque of task numbers, seeded with an even
+ * share of them.  It takes its own work from the back and, once it runs dry,
+ * steals from the front of the others'.  Tasks are whole runs, so a lock per
+ * deque costs next to nothing, and no task is added once the pool starts, so
+ * a worker that finds every deque empty is done. */
+typedef void (*pool_work)(void *context, size_t task, size_t worker);
+
+struct deque {
+    pthread_mutex_t mutex;
+
+    size_t head;
+    size_t tail;
+};
+
+struct pool {
+    struct deque *deques;
+    size_t number_of_workers;
+
+    pool_work work;
+    void *context;
+};
+
+struct worker {
+    struct pool *pool;
+    size_t index;
+
+    pthread_t thread;
+    int is_started;
+};
+
+static int take_task(struct pool *pool, size_t worker, size_t *task)
+{
+    size_t i = 0;
+
+    for (; i != pool->number_of_workers; ++i) {
+        struct deque *deque =
+            pool->deques + (worker + i) % pool->number_of_workers;
+
+        int is_taken = B_FALSE;
+
+        pthread_mutex_lock(&deque->mutex);
+
+        if (deque->head != deque->tail) {
+            *task = (i == 0) ? --deque->tail : deque->head++;
+            is_taken = B_TRUE;
+        }
+
+        pthread_mutex_unlock(&deque->mutex);
+
+        if (is_taken == B_TRUE) {
+            return B_TRUE;
+        }
+    }
+
+    return B_FALSE;
+}
+
+/* Each worker stays on a processor of its own, taken in turn from the ones
+ * the process may run on.  Whatever it touches first, its tape above all,
+ * then comes from the memory of that processor's node. */
+static void pin_worker(size_t index)
+{
+    cpu_set_t available;
+    cpu_set_t chosen;
+
+    int processor = 0;
+    int count = 0;
+
+    if (sched_getaffinity(0, sizeof(available), &available) != 0 ||
+        (count = CPU_COUNT(&available)) == 0) {
+        return;
+    }
+
+    index %= count;
+
+    for (; processor != CPU_SETSIZE; ++processor) {
+        if (CPU_ISSET(processor, &available) && index-- == 0) {
+            CPU_ZERO(&chosen);
+            CPU_SET(processor, &chosen);
+
+            pthread_setaffinity_np(pthread_self(), sizeof(chosen), &chosen);
+            return;
+        }
+    }
+}
+
+static void *work_on_pool(void *argument)
+{
+    struct worker *worker = argument;
+    size_t task = 0;
+
+    pin_worker(worker->index);
+
+    while (take_task(worker->pool, worker->index, &task) == B_TRUE) {
+        worker->pool->work(worker->pool->context, task, worker->index);
+    }
+
+    return NULL;
+}
+
+/* Runs every task and returns once they are all done.  The calling thread
+ * only waits, unless no worker could be started at all. */
+static int run_on_pool(size_t number_of_tasks, size_t number_of_workers,
+    pool_work work, void *context)
+{
+    struct pool pool = {NULL, number_of_workers, work, context};
+    struct worker *workers = calloc(number_of_workers, sizeof(struct worker));
+
+    size_t started = 0;
+    size_t i = 0;
+
+    pool.deques = calloc(number_of_workers, sizeof(struct deque));
+
+    if (workers == NULL || pool.deques == NULL) {
+        free(pool.deques);
+        free(workers);
+
+        return B_FALSE;
+    }
+
+    for (; i != number_of_workers; ++i) {
+        pthread_mutex_init(&pool.deques[i].mutex, NULL);
+
+        pool.deques[i].head = number_of_tasks * i / number_of_workers;
+        pool.deques[i].tail = number_of_tasks * (i + 1) / number_of_workers;
+
+        workers[i].pool = &pool;
+        workers[i].index = i;
+    }
+
+    /* Whatever a worker that fails to start would have done gets stolen. */
+    for (i = 0; i != number_of_workers; ++i) {
+        workers[i].is_started = pthread_create(&workers[i].thread, NULL,
+                                    work_on_pool, workers + i) == 0;
+        started += workers[i].is_started;
+    }
+
+    if (started == 0) {
+        while (take_task(&pool, 0, &i) == B_TRUE) {
+            work(context, i, 0);
+        }
+    }
+
+    for (i = 0; i != number_of_workers; ++i) {
+        if (workers[i].is_started == B_TRUE) {
+            pthread_join(workers[i].thread, NULL);
+        }
+    }
+
+    for (i = 0; i != number_of_workers; ++i) {
+        pthread_mutex_destroy(&pool.deques[i].mutex);
+    }
+
+    free(pool.deques);
+    free(workers);
+
+    return B_TRUE;
+}
+
+struct task {
+    char const *program;
+    char const *input;
+    char const *output;
+
+    enum brainfuck_status status;
+    char const *failure;
+
+    uint64_t number_of_executed_opcodes;
+    size_t input_length;
+    size_t output_length;
+
+    double compilation_time;
+    double run_time;
+};
+
+/* Output goes to a file, or nowhere, and is counted either way. */
+struct sink {
+    int descriptor;
+    size_t length;
+};
+
+/* Tasks share nothing they write to but their own slot.  When they all run
+ * the same program, that program is only ever read. */
+struct context {
+    struct batch const *batch;
+    struct brainfuck_program const *program;
+
+    char *manifest;
+    struct task *tasks;
+    size_t number_of_tasks;
+
+    struct brainfuck_tape **tapes;
+    size_t number_of_workers;
+
+    struct brainfuck_limits limits;
+};
+
+static inline double get_time(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static int write_sink(void *context, unsigned char const *buffer, size_t length)
+{
+    struct sink *sink = context;
+
+    sink->length += length;
+
+    while (sink->descriptor != -1 && length != 0) {
+        ssize_t result = write(sink->descriptor, buffer, length);
+
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+
+        if (result <= 0) {
+            return -1;
+        }
+
+        buffer += result;
+        length -= result;
+    }
+
+    return 0;
+}
+
+/* Input files are mapped and handed to the run whole. */
+static enum brainfuck_status map_input(
+    char const *filename, void **contents, size_t *length)
+{
+    struct stat status;
+    int descriptor = open(filename, O_RDONLY);
+
+    *contents = NULL;
+    *length = 0;
+
+    if (descriptor == -1 || fstat(descriptor, &status) != 0) {
+        if (descriptor != -1) {
+            close(descriptor);
+        }
+
+        return B_CANNOT_READ;
+    }
+
+    if (status.st_size != 0) {
+        *contents =
+            mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+        if (*contents == MAP_FAILED) {
+            *contents = NULL;
+            close(descriptor);
+
+            return B_CANNOT_READ;
+        }
+
+        *length = status.st_size;
+    }
+
+    close(descriptor);
+    return B_SUCCESS;
+}
+
+/* The tape of a worker is created on the worker's own thread, the first time
+ * it needs one, and reused for every task it runs after that. */
+static enum brainfuck_status run_task(struct context *context,
+    struct task *task, struct brainfuck_program const *program, size_t worker)
+{
+    struct brainfuck_options const *options = context->batch->options;
+    struct brainfuck_run_statistics statistics;
+
+    struct sink sink = {-1, 0};
+    struct brainfuck_io io = {NULL, 0, NULL, write_sink, &sink};
+
+    enum brainfuck_status status = B_SUCCESS;
+    void *input = NULL;
+
+    double start = 0.0;
+
+    if (context->tapes[worker] == NULL) {
+        status = brainfuck_create_tape(
+            options->container_length * options->cell_width / 8,
+            options->should_use_huge_pages, context->tapes + worker);
+    }
+
+    if (status == B_SUCCESS && task->input != NULL) {
+        status = map_input(task->input, &input, &io.input_length);
+        io.input = input;
+    }
+
+    if (status == B_SUCCESS && task->output != NULL &&
+        (sink.descriptor = open(task->output, O_WRONLY | O_CREAT | O_TRUNC,
+             0666)) == -1) {
+        status = B_CANNOT_WRITE;
+    }
+
+    if (status != B_SUCCESS) {
+        task->failure = "prepare";
+    } else {
+        start = get_time();
+        status = brainfuck_run(program, context->batch->engine,
+            context->tapes[worker], &io, &context->limits, &statistics);
+        task->run_time = get_time() - start;
+
+        task->failure = "run";
+        task->number_of_executed_opcodes =
+            statistics.number_of_executed_opcodes;
+    }
+
+    if (sink.descriptor != -1) {
+        close(sink.descriptor);
+    }
+
+    if (input != NULL) {
+        munmap(input, io.input_length);
+    }
+
+    task->input_length = io.input_length;
+    task->output_length = sink.length;
+
+    return status;
+}
+
+static void work_on_task(void *argument, size_t index, size_t worker)
+{
+    struct context *context = argument;
+    struct task *task = context->tasks + index;
+    struct brainfuck_program *program = NULL;
+
+    double start = get_time();
+
+    if (context->program != NULL) {
+        task->status = run_task(context, task, context->program, worker);
+        return;
+    }
+
+    task->status = brainfuck_compile_file(
+        task->program, context->batch->options, &program, NULL);
+    task->compilation_time = get_time() - start;
+
+    if (task->status != B_SUCCESS) {
+        task->failure = "compile";
+        return;
+    }
+
+    task->status = run_task(context, task, program, worker);
+    brainfuck_destroy_program(program);
+}
+
+/* Splits the manifest into tasks in place, so the names point into `text`.
+ * Without programs, a line only names an input and an output. */
+static size_t parse_manifest(char *text, struct task *tasks, int has_programs)
+{
+    size_t first = (has_programs == B_TRUE) ? 0 : 1;
+    size_t number_of_tasks = 0;
+    char *line = text;
+
+    while (line != NULL && *line != '\0') {
+        char *next = strchr(line, '\n');
+        char const *fields[3] = {NULL, NULL, NULL};
+
+        size_t i = first;
+        char *field = NULL;
+
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+
+        field = strtok(line, " \t\r");
+        line = next;
+
+        if (field == NULL || field[0] == '#') {
+            continue;
+        }
+
+        for (; field != NULL && i != 3; field = strtok(NULL, " \t\r")) {
+            fields[i++] = (strcmp(field, "-") == 0) ? NULL : field;
+        }
+
+        if (has_programs == B_TRUE && fields[0] == NULL) {
+            continue;
+        }
+
+        tasks[number_of_tasks].program = fields[0];
+        tasks[number_of_tasks].input = fields[1];
+        tasks[number_of_tasks++].output = fields[2];
+    }
+
+    return number_of_tasks;
+}
+
+static enum brainfuck_status read_manifest(char const *filename, char **result)
+{
+    FILE *file = fopen(filename, "rb");
+
+    char *text = NULL;
+    size_t length = 0;
+    size_t capacity = 4096;
+
+    enum brainfuck_status status = B_SUCCESS;
+
+    if (file == NULL) {
+        return B_CANNOT_READ;
+    }
+
+    if ((text = malloc(capacity)) == NULL) {
+        fclose(file);
+        return B_OUT_OF_MEMORY;
+    }
+
+    for (;;) {
+        char *larger = NULL;
+
+        length += fread(text + length, 1, capacity - length - 1, file);
+
+        if (length != capacity - 1) {
+            break;
+        }
+
+        if ((larger = realloc(text, capacity * 2)) == NULL) {
+            status = B_OUT_OF_MEMORY;
+            break;
+        }
+
+        text = larger;
+        capacity *= 2;
+    }
+
+    if (status == B_SUCCESS && ferror(file) != 0) {
+        status = B_CANNOT_READ;
+    }
+
+    fclose(file);
+
+    if (status != B_SUCCESS) {
+        free(text);
+        return status;
+    }
+
+    text[length] = '\0';
+    *result = text;
+
+    return B_SUCCESS;
+}
+
+static void report_tasks(struct task const *tasks, size_t number_of_tasks)
+{
+    size_t i = 0;
+
+    printf("program,input,status,opcodes,output_bytes,compile_ms,run_ms\n");
+
+    for (; i != number_of_tasks; ++i) {
+        struct task const *task = tasks + i;
+
+        printf("%s,%s,", task->program, task->input ? task->input : "-");
+
+        if (task->status == B_SUCCESS) {
+            printf("ok,");
+        } else {
+            printf("%s: %s,", task->failure,
+                brainfuck_describe_status(task->status));
+        }
+
+        printf("%" PRIu64 ",%zu,%.3f,%.3f\n", task->number_of_executed_opcodes,
+            task->output_length, task->compilation_time * 1e3,
+            task->run_time * 1e3);
+    }
+}
+
+/* Reads the manifest and runs every task in it, leaving the results in
+ * `context` for the caller to report and release. */
+static enum brainfuck_status run_manifest(
+    struct context *context, char const *manifest)
+{
+    char const *line = NULL;
+    size_t number_of_workers = context->batch->number_of_workers;
+
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_length = sysconf(_SC_PAGESIZE);
+
+    enum brainfuck_status status = read_manifest(manifest, &context->manifest);
+
+    if (status != B_SUCCESS) {
+        return status;
+    }
+
+    /* There are at most as many tasks as lines. */
+    context->number_of_tasks = 1;
+
+    for (line = context->manifest; (line = strchr(line, '\n')) != NULL;
+         ++line) {
+        ++context->number_of_tasks;
+    }
+
+    context->tasks = calloc(context->number_of_tasks, sizeof(struct task));
+
+    if (context->tasks == NULL) {
+        return B_OUT_OF_MEMORY;
+    }
+
+    context->number_of_tasks = parse_manifest(
+        context->manifest, context->tasks, context->program == NULL);
+
+    if (number_of_workers == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        number_of_workers = (online > 0) ? (size_t) online : 1;
+    }
+
+    if (number_of_workers > context->number_of_tasks) {
+        number_of_workers =
+            (context->number_of_tasks != 0) ? context->number_of_tasks : 1;
+    }
+
+    /* Unless told otherwise, a worker may use its share of half the memory
+     * for its tape, so a program that runs away with it fails alone instead
+     * of taking the whole batch down. */
+    if (context->batch->limits != NULL) {
+        context->limits = *context->batch->limits;
+    }
+
+    if (context->limits.tape_limit == 0 && pages > 0 && page_length > 0) {
+        context->limits.tape_limit =
+            (size_t) pages * (size_t) page_length / 2 / number_of_workers;
+    }
+
+    context->tapes =
+        calloc(number_of_workers, sizeof(struct brainfuck_tape *));
+
+    if (context->tapes == NULL) {
+        return B_OUT_OF_MEMORY;
+    }
+
+    context->number_of_workers = number_of_workers;
+
+    if (run_on_pool(context->number_of_tasks, number_of_workers,
+            work_on_task, context) == B_FALSE) {
+        return B_OUT_OF_MEMORY;
+    }
+
+    return B_SUCCESS;
+}
+
+/* What a batch that could not run at all returns in place of a count. */
+static long describe_failure(enum brainfuck_status status)
+{
+    return (status == B_OUT_OF_MEMORY) ? B_BATCH_OUT_OF_MEMORY
+                                       : B_BATCH_CANNOT_READ;
+}
+
+static long count_failures(struct context const *context)
+{
+    long failures = 0;
+    size_t i = 0;
+
+    for (; i != context->number_of_tasks; ++i) {
+        failures += context->tasks[i].status != B_SUCCESS;
+    }
+
+    return failures;
+}
+
+static void release_context(struct context *context)
+{
+    size_t i = 0;
+
+    for (; i != context->number_of_workers; ++i) {
+        brainfuck_destroy_tape(context->tapes[i]);
+    }
+
+    free(context->tapes);
+    free(context->tasks);
+    free(context->manifest);
+}
+
+long run_batch(struct batch const *batch, char const *manifest)
+{
+    struct context context = {
+        batch, NULL, NULL, NULL, 0, NULL, 0, {0, 0.0, 0}};
+
+    long failures = 0;
+    double start = get_time();
+
+    enum brainfuck_status status = run_manifest(&context, manifest);
+
+    if (status == B_SUCCESS) {
+        report_tasks(context.tasks, context.number_of_tasks);
+        failures = count_failures(&context);
+    } else {
+        failures = describe_failure(status);
+    }
+
+    if (failures >= 0 && batch->should_print_statistics == B_TRUE) {
+        fprintf(stderr, "%s: ran %zu programs on %zu threads in %.3f ms (%ld "
+                        "failed)\n",
+            batch->invocation, context.number_of_tasks,
+            context.number_of_workers, (get_time() - start) * 1e3, failures);
+    }
+
+    release_context(&context);
+    return failures;
+}
+
+long run_inputs(struct batch const *batch,
+    struct brainfuck_program const *program, char const *manifest)
+{
+    struct context context = {
+        batch, program, NULL, NULL, 0, NULL, 0, {0, 0.0, 0}};
+
+    long failures = 0;
+    double elapsed = 0.0;
+    double start = get_time();
+
+    size_t input_length = 0;
+    size_t output_length = 0;
+    size_t i = 0;
+
+    enum brainfuck_status status = run_manifest(&context, manifest);
+
+    failures = (status == B_SUCCESS) ? count_failures(&context)
+                                     : describe_failure(status);
+    elapsed = get_time() - start;
+
+    for (i = 0; failures >= 0 && i != context.number_of_tasks; ++i) {
+        struct task const *task = context.tasks + i;
+
+        input_length += task->input_length;
+        output_length += task->output_length;
+
+        if (task->status != B_SUCCESS) {
+            printf("%s: `%s`: %s\n", batch->invocation,
+                task->input ? task->input : "-",
+                brainfuck_describe_status(task->status));
+        }
+    }
+
+    fflush(stdout);
+
+    if (failures >= 0) {
+        fprintf(stderr,
+            "%s: ran %zu inputs (%.1f MiB in, %.1f MiB out) on %zu threads in "
+            "%.3f ms (%.1f inputs/s, %.1f MiB/s, %ld failed)\n",
+            batch->invocation, context.number_of_tasks,
+            input_length / (double) (1 << 20),
+            output_length / (double) (1 << 20), context.number_of_workers,
+            elapsed * 1e3,
+            (elapsed > 0) ? context.number_of_tasks / elapsed : 0.0,
+            (elapsed > 0) ? input_length / elapsed / (1 << 20) : 0.0,
+            failures);
+    }
+
+    release_context(&context);
+    return failures;
+}
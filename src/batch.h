@@ -0,0 +1,42 @@
+/* Batch runs for the command line: many programs, or one program over many
+ * inputs, at once, spread over a work-stealing pool with a thread per core. */
+
+#ifndef B_BATCH_H
+#define B_BATCH_H
+
+#include <stddef.h>
+
+#include "brainfuck.h"
+
+/* What the runs return instead of a count when they cannot start at all. */
+#define B_BATCH_CANNOT_READ (-1)
+#define B_BATCH_OUT_OF_MEMORY (-2)
+
+struct batch {
+    char const *invocation;
+
+    struct brainfuck_options const *options;
+    struct brainfuck_limits const *limits;
+    enum brainfuck_engine engine;
+
+    /* Zero means one per core. */
+    size_t number_of_workers;
+    int should_print_statistics;
+};
+
+/* Every line of the manifest names a program, and optionally the file it
+ * reads its input from and the file it writes its output to.  `-` stands
+ * for no file, blank lines and lines starting with `#` are skipped.  A row
+ * of results is printed for every program, in the order of the manifest.
+ * Returns how many programs failed, or one of the values above. */
+long run_batch(struct batch const *batch, char const *manifest);
+
+/* Runs `program` once for every line of the manifest, each naming an input
+ * and an output file like the last two fields of a batch manifest.  Every
+ * thread shares the program and works on a tape of its own.  Failures are
+ * printed as they are found after the runs, followed by the throughput on
+ * stderr.  Returns how many runs failed, or one of the values above. */
+long run_inputs(struct batch const *batch,
+    struct brainfuck_program const *program, char const *manifest);
+
+#endif
@@ -30,44 +30,90 @@
  *
  * This software is completely unlicensed. */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <string.h>
+#include <time.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 #include <llvm-c/Analysis.h>
 #include <llvm-c/BitWriter.h>
 #include <llvm-c/Core.h>
-#include <llvm-c/ExecutionEngine.h>
+#include <llvm-c/Error.h>
+#include <llvm-c/LLJIT.h>
+#include <llvm-c/Orc.h>
 #include <llvm-c/Target.h>
-#include <llvm-c/Transforms/PassManagerBuilder.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/Transforms/PassBuilder.h>
 
-#define B_VERSION_STRING "0.4"
-#define B_BUILD_FEATURES "core:llvm-ir:bin"
+#include "brainfuck.h"
 
 #define B_TRUE 1
 #define B_FALSE 0
 
+#if !defined(sigev_notify_thread_id)
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
 #define B_GENERIC_ADDRESS_SPACE 0
 
-static char *B_INVOCATION = NULL;
+#define B_MAXIMUM_LOOP_TERMS 32
+#define B_VECTOR_WIDTH 16
 
-static size_t B_CONTAINER_LENGTH = 30000;
+#define B_OUTPUT_BUFFER_LENGTH 65536
+#define B_INPUT_BUFFER_LENGTH 65536
+#define B_SOURCE_BLOCK_LENGTH (1 << 20)
 
-static int B_SHOULD_READ_FROM_STDIN = B_FALSE;
-static char const *B_INPUT_FILENAME = NULL;
+#define B_TAPE_EXTENT ((size_t) 1 << 30)
+#define B_HUGE_PAGE_LENGTH ((size_t) 1 << 21)
+#define B_FAULT_STACK_LENGTH 65536
+#define B_TIMEOUT_SIGNAL SIGRTMIN
+#define B_HOT_LOOP_THRESHOLD 10000
+#define B_CACHE_LIMIT ((size_t) 64 << 20)
 
-static int B_SHOULD_EMIT_C_CODE = B_FALSE;
-static char const *B_C_CODE_FILENAME = "brainfuck.c";
+#define B_PROFILE_ROWS 16
+#define B_MINIMUM_GUARD_LENGTH 4096
+#define B_EVALUATION_BUDGET ((uint64_t) 1 << 22)
+#define B_EVALUATION_WINDOW ((long) 1 << 16)
+#define B_EVALUATION_OUTPUT_LIMIT ((size_t) 1 << 20)
 
-static int B_SHOULD_EMIT_LLVM_IR = B_FALSE;
-static char const *B_LLVM_IR_FILENAME = "brainfuck.l";
+#if defined(__GNUC__)
+#define B_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define B_ALWAYS_INLINE inline
+#endif
 
-static int B_SHOULD_OPTIMIZE_CODE = B_TRUE;
-static int B_SHOULD_PRINT_BYTECODE_DISASSEMBLY = B_FALSE;
-static int B_SHOULD_EXPLAIN_CODE = B_FALSE;
-static int B_SHOULD_INTERPRET_CODE = B_TRUE;
-static int B_SHOULD_COMPILE_AND_EXECUTE = B_FALSE;
+#define B_WIDE_OPCODE 0x80
+#define B_MAXIMUM_PAYLOAD 0xFFFFFF
 
 enum instruction {
     B_INVALID = 0x00,
@@ -79,1013 +125,5792 @@ enum instruction {
     B_INPUT_CELL_VALUE = 0x2C, /* , */
     B_BRANCH_FORWARD = 0x5B, /* [ */
     B_BRANCH_BACKWARD = 0x5D, /* ] */
+    B_SET_CELL_VALUE = 0x3D, /* = */
+    B_MULTIPLY_CELL_VALUE = 0x2A, /* * */
+    B_SCAN_LEFT = 0x7B, /* { */
+    B_SCAN_RIGHT = 0x7D, /* } */
+    B_CHECK_TAPE = 0x21, /* ! */
+    B_OUTPUT_CONSTANT = 0x22, /* " */
     B_TERMINATE = 0xFF
 };
 
+/* `position` is the offset in the source of the first character the opcode
+ * came from (modulo 4 GiB, so that it fits next to the instruction), for the
+ * profiler to point back at.  A tape check covers the cells from `offset` to
+ * `source`, both relative to the pointer, and a constant output writes
+ * `auxiliary` bytes from `offset` on in the constants of the program. */
 struct opcode {
     enum instruction instruction;
+    uint32_t position;
     size_t auxiliary;
+    long offset;
+    long source;
 };
 
+/* The options a program was compiled with travel along with it, so every
+ * later stage reads them from here. */
 struct program {
     struct opcode *opcodes;
     size_t number_of_opcodes;
+    size_t source_length;
+
+    unsigned char *constants;
+    size_t constants_length;
+
+    char *name;
+    struct brainfuck_options options;
 };
 
-static inline long get_file_length(FILE *file)
-{
-    long position = 0L;
-    long length = 0L;
+/* One 32-bit word per opcode.  The low byte is the instruction, the rest
+ * packs its operands:
+ *
+ *   cell opcodes      | offset:16 | auxiliary:8 | instruction:8 |
+ *   multiply-add and  | source:8 | offset:8 | auxiliary:8 | instruction:8 |
+ *   tape checks
+ *   moves, scans and  | auxiliary:24 | instruction:8 |
+ *   branches
+ *
+ * An opcode whose operands do not fit sets `B_WIDE_OPCODE` in its
+ * instruction byte and keeps them in `operands` instead, indexed by the upper
+ * 24 bits.  Constant output always does.  Word indices match opcode indices,
+ * so branch targets carry over unchanged. */
+struct bytecode {
+    uint32_t *words;
+    size_t number_of_words;
+
+    struct opcode *operands;
+    size_t number_of_operands;
+
+    unsigned char const *constants;
+};
 
-    if (file == NULL) {
-        abort();
-    }
+/* The front end is a single streaming pass: source text comes in as chunks,
+ * comments are skipped, runs are collapsed and brackets are matched straight
+ * into the opcode array, which is the only copy of the program kept. */
+struct lexer {
+    struct program *program;
+    size_t capacity;
 
-    position = ftell(file);
+    struct opcode opcode;
 
-    if (position == -1L || fseek(file, 0, SEEK_END) != 0) {
-        abort();
-    }
+    size_t *brackets;
+    size_t depth;
+    size_t brackets_capacity;
 
-    length = ftell(file);
+    size_t position;
+};
 
-    if (length == -1L || fseek(file, position, SEEK_SET) != 0) {
-        abort();
+static void free_program(struct program *program)
+{
+    if (program != NULL) {
+        free(program->opcodes);
+        free(program->constants);
+        free(program->name);
     }
 
-    return length;
+    free(program);
 }
 
-static inline char *read_file(char const *filename)
+static void abandon_lexing(struct lexer *lexer)
 {
-    char *contents = NULL;
+    free_program(lexer->program);
+    free(lexer->brackets);
 
-    FILE *file = fopen(filename, "rt");
-    long file_length = 0;
+    lexer->program = NULL;
+    lexer->brackets = NULL;
+}
 
-    if (file == NULL) {
+static enum brainfuck_status begin_lexing(
+    struct lexer *lexer, struct brainfuck_options const *options)
+{
+    if (lexer == NULL || options == NULL) {
         abort();
     }
 
-    file_length = get_file_length(file);
-
-    if (file_length == 0) {
-        printf("%s: nothing to do\n", B_INVOCATION);
-        fclose(file);
-        abort();
-    }
+    lexer->program = calloc(1, sizeof(struct program));
+    lexer->capacity = 4096;
 
-    contents = malloc(sizeof(char) * file_length);
+    lexer->brackets_capacity = 256;
+    lexer->brackets = malloc(sizeof(size_t) * lexer->brackets_capacity);
 
-    if (contents == NULL) {
-        fclose(file);
-        abort();
+    if (lexer->program != NULL) {
+        lexer->program->opcodes =
+            malloc(sizeof(struct opcode) * lexer->capacity);
+        lexer->program->options = *options;
     }
 
-    if (fread(contents, file_length, 1, file) != 1UL) {
-        fclose(file);
-        abort();
+    if (lexer->program == NULL || lexer->program->opcodes == NULL ||
+        lexer->brackets == NULL) {
+        abandon_lexing(lexer);
+        return B_OUT_OF_MEMORY;
     }
 
-    fclose(file);
-    return contents;
-}
-
-static inline char *read_stdin(void)
-{
-    char buffer[1024];
-
-    size_t content_size = 1;
-    char *contents = malloc(sizeof(char) * 1024);
+    lexer->opcode.instruction = B_INVALID;
+    lexer->opcode.position = 0;
+    lexer->opcode.auxiliary = 0;
+    lexer->opcode.offset = 0;
+    lexer->opcode.source = 0;
 
-    if (contents == NULL) {
-        abort();
-    }
+    lexer->depth = 0;
+    lexer->position = 0;
 
-    *contents = '\0';
+    return B_SUCCESS;
+}
 
-    while (fgets(buffer, 1024, stdin)) {
-        char *old_contents = contents;
+static enum brainfuck_status emit_opcode(
+    struct lexer *lexer, struct opcode const *opcode)
+{
+    struct program *program = lexer->program;
 
-        content_size += strlen(buffer);
-        contents = realloc(contents, sizeof(char) * content_size);
+    if (program->number_of_opcodes == lexer->capacity) {
+        struct opcode *opcodes = realloc(
+            program->opcodes, sizeof(struct opcode) * lexer->capacity * 2);
 
-        if (contents == NULL) {
-            free(old_contents);
-            abort();
+        if (opcodes == NULL) {
+            return B_OUT_OF_MEMORY;
         }
 
-        strcat(contents, buffer);
+        program->opcodes = opcodes;
+        lexer->capacity *= 2;
     }
 
-    return contents;
+    program->opcodes[program->number_of_opcodes++] = *opcode;
+    return B_SUCCESS;
 }
 
-static inline int is_brainfuck_command(int command)
+static inline enum brainfuck_status flush_lexeme(struct lexer *lexer)
 {
-    char const commands[] = {'<', '>', '+', '-', '.', ',', '[', ']'};
-    return (memchr(commands, command, sizeof(commands)) != NULL);
+    enum brainfuck_status status = B_SUCCESS;
+
+    if (lexer->opcode.instruction != B_INVALID) {
+        status = emit_opcode(lexer, &(lexer->opcode));
+        lexer->opcode.instruction = B_INVALID;
+    }
+
+    return status;
 }
 
-static inline char *sanitize(char **source_code)
+/* On an unmatched `]`, `position` is left pointing at it. */
+static enum brainfuck_status lex(
+    struct lexer *lexer, char const *source, size_t length)
 {
-    int i = 0;
-    int j = 0;
+    size_t i = 0;
 
-    char *output = NULL;
+    enum brainfuck_status status = B_SUCCESS;
 
-    if (source_code == NULL || *source_code == NULL) {
+    if (lexer == NULL || source == NULL) {
         abort();
     }
 
-    output = malloc(sizeof(char) * strlen(*source_code));
+    for (; i != length && status == B_SUCCESS; ++i) {
+        struct opcode opcode = {B_INVALID, 0, 1, 0, 0};
 
-    if (output == NULL) {
-        abort();
-    }
+        opcode.position = (uint32_t) (lexer->position + i);
+
+        switch (source[i]) {
+        case B_MOVE_POINTER_LEFT:
+        case B_MOVE_POINTER_RIGHT:
+        case B_INCREMENT_CELL_VALUE:
+        case B_DECREMENT_CELL_VALUE:
+        case B_OUTPUT_CELL_VALUE:
+            if (lexer->opcode.instruction == (enum instruction) source[i] &&
+                lexer->program->options.should_optimize == B_TRUE) {
+                ++(lexer->opcode.auxiliary);
+                break;
+            }
+
+            status = flush_lexeme(lexer);
+
+            lexer->opcode.instruction = source[i];
+            lexer->opcode.position = opcode.position;
+            lexer->opcode.auxiliary = 1;
+
+            break;
+
+        case B_INPUT_CELL_VALUE:
+            if ((status = flush_lexeme(lexer)) != B_SUCCESS) {
+                break;
+            }
+
+            opcode.instruction = B_INPUT_CELL_VALUE;
+            status = emit_opcode(lexer, &opcode);
 
-    for (i = 0; (*source_code)[i]; ++i) {
-        if (is_brainfuck_command((*source_code)[i])) {
-            output[j++] = (*source_code)[i];
+            break;
+
+        case B_BRANCH_FORWARD:
+            if ((status = flush_lexeme(lexer)) != B_SUCCESS) {
+                break;
+            }
+
+            if (lexer->depth == lexer->brackets_capacity) {
+                size_t *brackets = realloc(lexer->brackets,
+                    sizeof(size_t) * lexer->brackets_capacity * 2);
+
+                if (brackets == NULL) {
+                    status = B_OUT_OF_MEMORY;
+                    break;
+                }
+
+                lexer->brackets = brackets;
+                lexer->brackets_capacity *= 2;
+            }
+
+            lexer->brackets[lexer->depth++] = lexer->program->number_of_opcodes;
+
+            opcode.instruction = B_BRANCH_FORWARD;
+            status = emit_opcode(lexer, &opcode);
+
+            break;
+
+        case B_BRANCH_BACKWARD:
+            if ((status = flush_lexeme(lexer)) != B_SUCCESS) {
+                break;
+            }
+
+            if (lexer->depth == 0) {
+                lexer->position += i;
+                return B_UNMATCHED_BRACKET;
+            }
+
+            --(lexer->depth);
+
+            opcode.instruction = B_BRANCH_BACKWARD;
+            opcode.auxiliary = lexer->brackets[lexer->depth];
+
+            lexer->program->opcodes[opcode.auxiliary].auxiliary =
+                lexer->program->number_of_opcodes;
+
+            status = emit_opcode(lexer, &opcode);
+            break;
+
+        default:
+            break;
         }
     }
 
-    free(*source_code);
-    *source_code = output;
-
-    return output;
+    lexer->position += length;
+    return status;
 }
 
-static struct program *run_length_encode(char const *source_code)
+/* On an unmatched `[`, `position` is set to the innermost one. */
+static enum brainfuck_status finish_lexing(
+    struct lexer *lexer, struct program **result)
 {
-    size_t i = 0;
-    char const *command = NULL;
-
+    struct opcode opcode = {B_TERMINATE, 0, 0, 0, 0};
     struct program *program = NULL;
-    struct opcode opcode;
 
-    if (source_code == NULL) {
+    enum brainfuck_status status = B_SUCCESS;
+
+    if (lexer == NULL || result == NULL) {
         abort();
     }
 
-    program = malloc(sizeof(struct program));
+    opcode.position = (uint32_t) lexer->position;
 
-    if (program == NULL) {
-        abort();
+    if (lexer->depth != 0) {
+        lexer->position =
+            lexer->program->opcodes[lexer->brackets[lexer->depth - 1]]
+                .position;
+
+        abandon_lexing(lexer);
+        return B_UNMATCHED_BRACKET;
     }
 
-    program->opcodes =
-        malloc(sizeof(struct opcode) * (strlen(source_code) + 1));
+    if ((status = flush_lexeme(lexer)) != B_SUCCESS ||
+        (status = emit_opcode(lexer, &opcode)) != B_SUCCESS) {
+        abandon_lexing(lexer);
+        return status;
+    }
+
+    free(lexer->brackets);
+
+    program = lexer->program;
+    program->source_length = lexer->position;
+    program->opcodes = realloc(
+        program->opcodes, sizeof(struct opcode) * program->number_of_opcodes);
 
     if (program->opcodes == NULL) {
-        free(program);
-        abort();
+        free_program(program);
+        return B_OUT_OF_MEMORY;
     }
 
-    opcode.instruction = B_INVALID;
-    opcode.auxiliary = 0;
+    *result = program;
+    return B_SUCCESS;
+}
 
-    for (command = source_code; *command; ++command) {
-        switch (*command) {
-        case B_OUTPUT_CELL_VALUE:
-        case B_INPUT_CELL_VALUE:
-        case B_BRANCH_FORWARD:
-        case B_BRANCH_BACKWARD:
-            if (opcode.instruction != B_INVALID) {
-                memcpy(program->opcodes + i, &opcode, sizeof(opcode));
-                ++i;
-            }
+static enum brainfuck_status load_source(char const *source, size_t length,
+    struct brainfuck_options const *options, struct program **program,
+    size_t *position)
+{
+    struct lexer lexer;
+    enum brainfuck_status status = begin_lexing(&lexer, options);
+
+    if (status != B_SUCCESS) {
+        return status;
+    }
 
-            opcode.instruction = *command;
-            opcode.auxiliary = 1;
+    if ((status = lex(&lexer, source, length)) != B_SUCCESS) {
+        abandon_lexing(&lexer);
+    } else {
+        status = finish_lexing(&lexer, program);
+    }
 
-            break;
+    if (status == B_UNMATCHED_BRACKET && position != NULL) {
+        *position = lexer.position;
+    }
 
-        default:
-            if (opcode.instruction != *command) {
-                if (opcode.instruction != B_INVALID) {
-                    memcpy(program->opcodes + i, &opcode, sizeof(opcode));
-                    ++i;
-                }
+    return status;
+}
 
-                opcode.instruction = *command;
-                opcode.auxiliary = 1;
+static enum brainfuck_status load_file(char const *filename,
+    struct brainfuck_options const *options, struct program **program,
+    size_t *position)
+{
+    struct stat status;
 
-                break;
-            }
+    void *contents = NULL;
+    int descriptor = open(filename, O_RDONLY);
+
+    enum brainfuck_status result = B_SUCCESS;
 
-            ++(opcode.auxiliary);
+    if (descriptor == -1 || fstat(descriptor, &status) != 0) {
+        if (descriptor != -1) {
+            close(descriptor);
         }
+
+        return B_CANNOT_READ;
     }
 
-    memcpy(program->opcodes + i, &opcode, sizeof(opcode));
-    ++i;
+    if (status.st_size == 0) {
+        close(descriptor);
+        return B_NOTHING_TO_DO;
+    }
 
-    opcode.instruction = B_TERMINATE;
-    opcode.auxiliary = 0;
+    contents =
+        mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
 
-    memcpy(program->opcodes + i, &opcode, sizeof(opcode));
-    ++i;
+    if (contents == MAP_FAILED) {
+        close(descriptor);
+        return B_CANNOT_READ;
+    }
 
-    program->number_of_opcodes = i;
-    return program;
+    madvise(contents, status.st_size, MADV_SEQUENTIAL);
+
+    result = load_source(contents, status.st_size, options, program, position);
+
+    munmap(contents, status.st_size);
+    close(descriptor);
+
+    return result;
 }
 
-static struct program *link_branches(struct program *program)
+/* Reads stdin a block at a time and lexes each block as it arrives, so the
+ * cost stays linear in the size of the program. */
+static enum brainfuck_status load_stdin(struct brainfuck_options const *options,
+    struct program **program, size_t *position)
 {
-    int i = 0;
-    int j = 0;
+    struct lexer lexer;
+    char *buffer = malloc(B_SOURCE_BLOCK_LENGTH);
 
-    long *stack = NULL;
+    enum brainfuck_status status = B_SUCCESS;
 
-    if (program == NULL || program->opcodes == NULL) {
-        abort();
+    if (buffer == NULL) {
+        return B_OUT_OF_MEMORY;
     }
 
-    stack = malloc(sizeof(long) * program->number_of_opcodes);
-
-    if (stack == NULL) {
-        abort();
+    if ((status = begin_lexing(&lexer, options)) != B_SUCCESS) {
+        free(buffer);
+        return status;
     }
 
-    for (i = 0; i != (int) program->number_of_opcodes; ++i) {
-        switch (program->opcodes[i].instruction) {
-        case B_BRANCH_FORWARD:
-            stack[j++] = i;
-            break;
-
-        case B_BRANCH_BACKWARD:
-            --j;
+    while (status == B_SUCCESS) {
+        ssize_t length = read(STDIN_FILENO, buffer, B_SOURCE_BLOCK_LENGTH);
 
-            program->opcodes[i].auxiliary = stack[j];
-            program->opcodes[stack[j]].auxiliary = i;
+        if (length == -1 && errno == EINTR) {
+            continue;
+        }
 
-        default:
+        if (length == -1) {
+            status = B_CANNOT_READ;
+        } else if (length == 0) {
             break;
+        } else {
+            status = lex(&lexer, buffer, length);
         }
     }
 
-    return program;
+    free(buffer);
+
+    if (status != B_SUCCESS) {
+        abandon_lexing(&lexer);
+    } else {
+        status = finish_lexing(&lexer, program);
+    }
+
+    if (status == B_UNMATCHED_BRACKET && position != NULL) {
+        *position = lexer.position;
+    }
+
+    return status;
 }
 
-static void interpret(struct program const *program)
+static inline double get_time(void)
 {
-    size_t i = 0;
+    struct timespec time;
 
-    char *container = NULL;
-    char *pointer = NULL;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
 
-    if (program == NULL || program->opcodes == NULL) {
-        abort();
-    }
+/* Cells are unsigned and wrap at their width, so cell arithmetic is done in
+ * `size_t` and reduced with this mask wherever a constant is folded. */
+static inline size_t get_cell_mask(struct program const *program)
+{
+    return (size_t) (UINT64_MAX >> (64 - program->options.cell_width));
+}
 
-    container = calloc(B_CONTAINER_LENGTH, sizeof(char));
+struct term {
+    long offset;
+    size_t factor;
+};
 
-    if (container == NULL) {
-        abort();
+/* Collects the net change a flat loop body makes to each cell it touches.
+ * Returns the number of terms, with the loop cell itself first, or zero if
+ * the body moves the pointer, nests or does anything but arithmetic. */
+static size_t analyze_balanced_loop(struct opcode const *opcodes,
+    size_t length, struct term *terms, size_t *loop_length)
+{
+    size_t i = 1;
+    size_t j = 0;
+    size_t number_of_terms = 1;
+
+    long position = 0;
+
+    if (length < 2 || opcodes[0].instruction != B_BRANCH_FORWARD) {
+        return 0;
     }
 
-    pointer = container;
+    terms[0].offset = 0;
+    terms[0].factor = 0;
 
-    for (; i != program->number_of_opcodes; ++i) {
-        switch (program->opcodes[i].instruction) {
+    for (; i != length; ++i) {
+        switch (opcodes[i].instruction) {
         case B_MOVE_POINTER_LEFT:
-            pointer -= program->opcodes[i].auxiliary;
-            break;
+            position -= (long) opcodes[i].auxiliary;
+            continue;
 
         case B_MOVE_POINTER_RIGHT:
-            pointer += program->opcodes[i].auxiliary;
-            break;
+            position += (long) opcodes[i].auxiliary;
+            continue;
 
         case B_INCREMENT_CELL_VALUE:
-            *pointer += program->opcodes[i].auxiliary;
-            break;
-
         case B_DECREMENT_CELL_VALUE:
-            *pointer -= program->opcodes[i].auxiliary;
-            break;
+            for (j = 0; j != number_of_terms; ++j) {
+                if (terms[j].offset == position) {
+                    break;
+                }
+            }
 
-        case B_OUTPUT_CELL_VALUE:
-            putchar(*pointer);
-            break;
+            if (j == number_of_terms) {
+                if (number_of_terms == B_MAXIMUM_LOOP_TERMS) {
+                    return 0;
+                }
 
-        case B_INPUT_CELL_VALUE:
-            *pointer = getchar();
-            break;
+                terms[j].offset = position;
+                terms[j].factor = 0;
 
-        case B_BRANCH_FORWARD:
-            if (*pointer == 0) {
-                i = program->opcodes[i].auxiliary;
+                ++number_of_terms;
             }
 
-            break;
-
-        case B_BRANCH_BACKWARD:
-            if (*pointer != 0) {
-                i = program->opcodes[i].auxiliary;
+            if (opcodes[i].instruction == B_INCREMENT_CELL_VALUE) {
+                terms[j].factor += opcodes[i].auxiliary;
+            } else {
+                terms[j].factor -= opcodes[i].auxiliary;
             }
 
-            break;
+            continue;
 
-        case B_TERMINATE:
-            if (i != program->number_of_opcodes - 1) {
-                printf("%s: premature termination @ %zd\n", B_INVOCATION, i);
+        case B_BRANCH_BACKWARD:
+            if (position != 0) {
+                return 0;
             }
 
+            *loop_length = i + 1;
+            return number_of_terms;
+
         default:
-            break;
+            return 0;
         }
     }
 
-    free(container);
-}
-
-static LLVMModuleRef optimize_llvm_module(LLVMModuleRef module)
-{
-    LLVMPassManagerRef manager = LLVMCreatePassManager();
-    LLVMPassManagerBuilderRef builder = LLVMPassManagerBuilderCreate();
-    LLVMPassManagerBuilderSetOptLevel(builder, 3);
-
-    LLVMPassManagerBuilderPopulateModulePassManager(builder, manager);
-    LLVMRunPassManager(manager, module);
-
-    LLVMPassManagerBuilderDispose(builder);
-    LLVMDisposePassManager(manager);
-
-    return module;
+    return 0;
 }
 
-static LLVMModuleRef build_llvm_module(struct program const *program)
+/* A balanced loop whose cell steps by one runs exactly as many times as that
+ * cell says (or its negation when it counts up), so each other cell it
+ * touches just receives a multiple of the loop cell's value. */
+static struct program *eliminate_multiply_loops(struct program *program)
 {
     size_t i = 0;
+    size_t j = 0;
     size_t k = 0;
 
+    size_t mask = 0;
+    struct term terms[B_MAXIMUM_LOOP_TERMS];
+
     if (program == NULL || program->opcodes == NULL) {
         abort();
     }
 
-    LLVMModuleRef module = LLVMModuleCreateWithName("brainfuck");
-    LLVMBuilderRef builder = LLVMCreateBuilder();
-
-    LLVMValueRef container = NULL;
-    LLVMValueRef index = NULL;
+    mask = get_cell_mask(program);
 
-    LLVMBasicBlockRef start = NULL;
-    LLVMBasicBlockRef end = NULL;
+    for (; i != program->number_of_opcodes; ++i) {
+        size_t loop_length = 0;
+        size_t number_of_terms = analyze_balanced_loop(program->opcodes + i,
+            program->number_of_opcodes - i, terms, &loop_length);
 
-    LLVMBasicBlockRef *stack =
-        malloc(sizeof(LLVMBasicBlockRef) * program->number_of_opcodes);
+        size_t step = (number_of_terms > 1) ? terms[0].factor & mask : 0;
+        uint32_t position = program->opcodes[i].position;
 
-    if (stack == NULL) {
-        abort();
-    }
+        if (step == 1 || step == mask) {
+            for (k = 1; k != number_of_terms; ++k) {
+                if ((terms[k].factor & mask) == 0) {
+                    continue;
+                }
 
-    {
-        LLVMTypeRef parameters[] = {LLVMInt32Type(), LLVMInt32Type()};
+                program->opcodes[j].instruction = B_MULTIPLY_CELL_VALUE;
+                program->opcodes[j].position = position;
+                program->opcodes[j].auxiliary = mask &
+                    (step == 1 ? -terms[k].factor : terms[k].factor);
+                program->opcodes[j].offset = terms[k].offset;
+                program->opcodes[j].source = 0;
 
-        LLVMTypeRef result =
-            LLVMPointerType(LLVMInt8Type(), B_GENERIC_ADDRESS_SPACE);
+                ++j;
+            }
 
-        LLVMTypeRef function = LLVMFunctionType(result, parameters, 2, B_FALSE);
+            program->opcodes[j].instruction = B_SET_CELL_VALUE;
+            program->opcodes[j].position = position;
+            program->opcodes[j].auxiliary = 0;
+            program->opcodes[j].offset = 0;
+            program->opcodes[j].source = 0;
 
-        LLVMAddFunction(module, "calloc", function);
-    }
+            ++j;
+            i += loop_length - 1;
 
-    {
-        LLVMTypeRef function =
-            LLVMFunctionType(LLVMInt32Type(), NULL, 0, B_FALSE);
+            continue;
+        }
 
-        LLVMAddFunction(module, "getchar", function);
+        program->opcodes[j++] = program->opcodes[i];
     }
 
-    {
-        LLVMTypeRef parameters[] = {LLVMInt32Type()};
-        LLVMTypeRef function =
-            LLVMFunctionType(LLVMInt32Type(), parameters, 1, B_FALSE);
+    program->number_of_opcodes = j;
+    return program;
+}
 
-        LLVMAddFunction(module, "putchar", function);
-    }
+static inline int is_clear_loop(struct opcode const *opcodes)
+{
+    return opcodes[0].instruction == B_BRANCH_FORWARD &&
+        (opcodes[1].instruction == B_INCREMENT_CELL_VALUE ||
+            opcodes[1].instruction == B_DECREMENT_CELL_VALUE) &&
+        (opcodes[1].auxiliary & 1) == 1 &&
+        opcodes[2].instruction == B_BRANCH_BACKWARD;
+}
 
-    {
-        LLVMTypeRef function =
-            LLVMFunctionType(LLVMVoidType(), NULL, 0, B_FALSE);
+static inline int is_scan_loop(struct opcode const *opcodes)
+{
+    return opcodes[0].instruction == B_BRANCH_FORWARD &&
+        (opcodes[1].instruction == B_MOVE_POINTER_LEFT ||
+            opcodes[1].instruction == B_MOVE_POINTER_RIGHT) &&
+        opcodes[2].instruction == B_BRANCH_BACKWARD;
+}
 
-        LLVMValueRef main = LLVMAddFunction(module, "main", function);
-        LLVMBasicBlockRef entry = LLVMAppendBasicBlock(main, "entry");
+static struct program *recognize_idioms(struct program *program)
+{
+    size_t i = 0;
+    size_t j = 0;
 
-        LLVMPositionBuilderAtEnd(builder, entry);
+    if (program == NULL || program->opcodes == NULL) {
+        abort();
     }
 
-    {
-        LLVMValueRef function = LLVMGetNamedFunction(module, "calloc");
-        LLVMValueRef arguments[] = {
-            LLVMConstInt(LLVMInt32Type(), B_CONTAINER_LENGTH, B_FALSE),
-            LLVMConstInt(LLVMInt32Type(), sizeof(char), B_FALSE)};
+    /* An odd step always reaches zero, so `[-]`, `[+]` and the like are
+     * replaced with a single store.  Arithmetic right before the store is
+     * dead, and arithmetic right after it folds into the stored constant. */
+    for (; i != program->number_of_opcodes; ++i) {
+        struct opcode *opcode = program->opcodes + i;
+        uint32_t position = opcode->position;
+
+        if (i + 2 < program->number_of_opcodes && is_clear_loop(opcode)) {
+            while (j != 0 &&
+                (program->opcodes[j - 1].instruction ==
+                        B_INCREMENT_CELL_VALUE ||
+                    program->opcodes[j - 1].instruction ==
+                        B_DECREMENT_CELL_VALUE ||
+                    program->opcodes[j - 1].instruction == B_SET_CELL_VALUE)) {
+                --j;
+            }
 
-        LLVMValueRef zero = LLVMConstInt(LLVMInt32Type(), 0, B_FALSE);
+            program->opcodes[j].instruction = B_SET_CELL_VALUE;
+            program->opcodes[j].position = position;
+            program->opcodes[j].auxiliary = 0;
+            program->opcodes[j].offset = 0;
+            program->opcodes[j].source = 0;
 
-        container = LLVMBuildCall(builder, function, arguments, 2, "container");
+            ++j;
+            i += 2;
 
-        index = LLVMBuildAlloca(builder, LLVMInt32Type(), "index");
-        LLVMBuildStore(builder, zero, index);
-    }
+            continue;
+        }
 
-    for (; i < program->number_of_opcodes; ++i) {
-        switch (program->opcodes[i].instruction) {
-        case B_MOVE_POINTER_LEFT: {
-            LLVMValueRef value = LLVMBuildLoad(builder, index, "");
-            LLVMValueRef amount = LLVMConstInt(LLVMInt32Type(),
-                program->opcodes[i].auxiliary, B_GENERIC_ADDRESS_SPACE);
+        /* `[>]`, `[<<]` and so on look for the next zero cell at a fixed
+         * stride, which the scan kernels do a vector at a time. */
+        if (i + 2 < program->number_of_opcodes && is_scan_loop(opcode)) {
+            program->opcodes[j].instruction =
+                (opcode[1].instruction == B_MOVE_POINTER_LEFT) ? B_SCAN_LEFT
+                                                              : B_SCAN_RIGHT;
+            program->opcodes[j].position = position;
+            program->opcodes[j].auxiliary = opcode[1].auxiliary;
+            program->opcodes[j].offset = 0;
+            program->opcodes[j].source = 0;
+
+            ++j;
+            i += 2;
+
+            continue;
+        }
 
-            LLVMValueRef result = LLVMBuildSub(builder, value, amount, "");
+        if (j != 0 && program->opcodes[j - 1].instruction == B_SET_CELL_VALUE) {
+            if (opcode->instruction == B_INCREMENT_CELL_VALUE) {
+                program->opcodes[j - 1].auxiliary = get_cell_mask(program) &
+                    (program->opcodes[j - 1].auxiliary + opcode->auxiliary);
+                continue;
+            }
 
-            LLVMBuildStore(builder, result, index);
-            break;
+            if (opcode->instruction == B_DECREMENT_CELL_VALUE) {
+                program->opcodes[j - 1].auxiliary = get_cell_mask(program) &
+                    (program->opcodes[j - 1].auxiliary - opcode->auxiliary);
+                continue;
+            }
         }
 
-        case B_MOVE_POINTER_RIGHT: {
-            LLVMValueRef value = LLVMBuildLoad(builder, index, "");
-            LLVMValueRef amount = LLVMConstInt(LLVMInt32Type(),
-                program->opcodes[i].auxiliary, B_GENERIC_ADDRESS_SPACE);
+        program->opcodes[j++] = *opcode;
+    }
 
-            LLVMValueRef result = LLVMBuildAdd(builder, value, amount, "");
+    program->number_of_opcodes = j;
+    return program;
+}
 
-            LLVMBuildStore(builder, result, index);
+static inline int is_cell_instruction(enum instruction instruction)
+{
+    switch (instruction) {
+    case B_INCREMENT_CELL_VALUE:
+    case B_DECREMENT_CELL_VALUE:
+    case B_OUTPUT_CELL_VALUE:
+    case B_INPUT_CELL_VALUE:
+    case B_SET_CELL_VALUE:
+    case B_MULTIPLY_CELL_VALUE:
+        return B_TRUE;
+
+    default:
+        return B_FALSE;
+    }
+}
+
+/* Pointer moves are deferred through straight-line code: every cell opcode
+ * addresses `pointer + offset` instead, and the accumulated movement is only
+ * applied once, right before the next branch or scan.  Movement left over at
+ * termination is dropped altogether. */
+static struct program *sink_pointer_movement(struct program *program)
+{
+    size_t i = 0;
+    size_t j = 0;
+
+    long shift = 0;
+
+    if (program == NULL || program->opcodes == NULL) {
+        abort();
+    }
+
+    for (; i != program->number_of_opcodes; ++i) {
+        struct opcode opcode = program->opcodes[i];
+
+        switch (opcode.instruction) {
+        case B_MOVE_POINTER_LEFT:
+            shift -= (long) opcode.auxiliary;
+            continue;
+
+        case B_MOVE_POINTER_RIGHT:
+            shift += (long) opcode.auxiliary;
+            continue;
+
+        default:
             break;
         }
 
-        case B_INCREMENT_CELL_VALUE: {
-            LLVMValueRef offset = LLVMBuildLoad(builder, index, "");
+        if (is_cell_instruction(opcode.instruction)) {
+            opcode.offset += shift;
+            opcode.source += shift;
 
-            LLVMValueRef cell =
-                LLVMBuildGEP(builder, container, &offset, 1, "");
+            program->opcodes[j++] = opcode;
+            continue;
+        }
 
-            LLVMValueRef value = LLVMBuildLoad(builder, cell, "");
-            LLVMValueRef increment = LLVMBuildAdd(builder, value,
-                LLVMConstInt(
-                    LLVMInt8Type(), program->opcodes[i].auxiliary, B_FALSE),
-                "");
+        if (opcode.instruction == B_TERMINATE) {
+            shift = 0;
+        }
 
-            LLVMBuildStore(builder, increment, cell);
+        if (shift != 0) {
+            program->opcodes[j].instruction =
+                (shift < 0) ? B_MOVE_POINTER_LEFT : B_MOVE_POINTER_RIGHT;
+            program->opcodes[j].position = opcode.position;
+            program->opcodes[j].auxiliary = (shift < 0) ? -shift : shift;
+            program->opcodes[j].offset = 0;
+            program->opcodes[j].source = 0;
+
+            ++j;
+            shift = 0;
+        }
+
+        program->opcodes[j++] = opcode;
+    }
+
+    program->number_of_opcodes = j;
+    return program;
+}
+
+static enum brainfuck_status link_branches(struct program *program)
+{
+    int i = 0;
+    int j = 0;
+
+    long *stack = NULL;
+
+    if (program == NULL || program->opcodes == NULL) {
+        abort();
+    }
+
+    stack = malloc(sizeof(long) * program->number_of_opcodes);
+
+    if (stack == NULL) {
+        return B_OUT_OF_MEMORY;
+    }
+
+    for (i = 0; i != (int) program->number_of_opcodes; ++i) {
+        switch (program->opcodes[i].instruction) {
+        case B_BRANCH_FORWARD:
+            stack[j++] = i;
+            break;
+
+        case B_BRANCH_BACKWARD:
+            --j;
+
+            program->opcodes[i].auxiliary = stack[j];
+            program->opcodes[stack[j]].auxiliary = i;
+
+        default:
             break;
         }
+    }
 
-        case B_DECREMENT_CELL_VALUE: {
-            LLVMValueRef offset = LLVMBuildLoad(builder, index, "");
+    free(stack);
+    return B_SUCCESS;
+}
+
+/* Safe mode follows the range the pointer can be in, in cells from the
+ * first one, and checks the tape only where that range does not already put
+ * every access on it.  A loop that leaves the pointer where it found it is
+ * checked once before it is entered, for every cell it touches; any other
+ * loop has its blocks checked once per iteration.  A scan stops on a cell it
+ * has read, so the guard granule catches it, unless its stride could step
+ * right over the granule. */
+struct tape_range {
+    long low;
+    long high;
+};
 
-            LLVMValueRef cell =
-                LLVMBuildGEP(builder, container, &offset, 1, "");
+struct range_analysis {
+    struct program const *program;
+    long extent;
 
-            LLVMValueRef value = LLVMBuildLoad(builder, cell, "");
-            LLVMValueRef decrement = LLVMBuildSub(builder, value,
-                LLVMConstInt(
-                    LLVMInt8Type(), program->opcodes[i].auxiliary, B_FALSE),
-                "");
+    /* Per `[`: 0 until the loop is looked at, then 1 if it leaves the
+     * pointer where it found it and -1 if not.  The footprint of such a loop
+     * is every cell it touches, relative to its header. */
+    signed char *invariance;
+    struct tape_range *footprints;
+
+    struct opcode *result;
+    size_t length;
+    size_t number_of_checks;
+};
+
+static inline void extend_range(struct tape_range *range, long low, long high)
+{
+    if (low < range->low) {
+        range->low = low;
+    }
+
+    if (high > range->high) {
+        range->high = high;
+    }
+}
+
+static int is_invariant_loop(struct range_analysis *analysis, size_t loop)
+{
+    struct opcode const *opcodes = analysis->program->opcodes;
+    struct tape_range footprint = {0, 0};
+
+    size_t i = loop + 1;
+    long shift = 0;
+
+    if (analysis->invariance[loop] != 0) {
+        return analysis->invariance[loop] > 0;
+    }
+
+    analysis->invariance[loop] = -1;
+
+    for (; i != opcodes[loop].auxiliary; ++i) {
+        struct opcode const *opcode = opcodes + i;
+
+        if (is_cell_instruction(opcode->instruction)) {
+            extend_range(&footprint, shift + opcode->offset,
+                shift + opcode->offset);
+
+            if (opcode->instruction == B_MULTIPLY_CELL_VALUE) {
+                extend_range(&footprint, shift + opcode->source,
+                    shift + opcode->source);
+            }
+
+            continue;
+        }
+
+        switch (opcode->instruction) {
+        case B_MOVE_POINTER_LEFT:
+            shift -= (long) opcode->auxiliary;
+            break;
+
+        case B_MOVE_POINTER_RIGHT:
+            shift += (long) opcode->auxiliary;
+            break;
+
+        case B_BRANCH_FORWARD:
+            if (!is_invariant_loop(analysis, i)) {
+                return B_FALSE;
+            }
+
+            extend_range(&footprint, shift + analysis->footprints[i].low,
+                shift + analysis->footprints[i].high);
+
+            i = opcode->auxiliary;
+            break;
+
+        case B_SCAN_LEFT:
+        case B_SCAN_RIGHT:
+            return B_FALSE;
+
+        default:
+            break;
+        }
+    }
+
+    if (shift != 0) {
+        return B_FALSE;
+    }
+
+    analysis->footprints[loop] = footprint;
+    analysis->invariance[loop] = 1;
+
+    return B_TRUE;
+}
+
+static void emit_tape_check(struct range_analysis *analysis, long low,
+    long high, uint32_t position)
+{
+    struct opcode *opcode = analysis->result + analysis->length++;
+
+    opcode->instruction = B_CHECK_TAPE;
+    opcode->position = position;
+    opcode->auxiliary = 0;
+    opcode->offset = low;
+    opcode->source = high;
+
+    ++(analysis->number_of_checks);
+}
+
+static void copy_opcodes(
+    struct range_analysis *analysis, size_t first, size_t last)
+{
+    memcpy(analysis->result + analysis->length,
+        analysis->program->opcodes + first,
+        sizeof(struct opcode) * (last - first));
+
+    analysis->length += last - first;
+}
+
+/* Checks the cells of `footprint`, relative to the pointer, unless `pointer`
+ * already puts them all on the tape.  Past a check, the pointer is known to
+ * be wherever the check lets it through. */
+static void guard_footprint(struct range_analysis *analysis,
+    struct tape_range *pointer, struct tape_range const *footprint,
+    uint32_t position)
+{
+    long extent = analysis->extent;
+
+    if (footprint->low > footprint->high ||
+        (pointer->low + footprint->low >= -extent &&
+            pointer->high + footprint->high < extent)) {
+        return;
+    }
+
+    emit_tape_check(analysis, footprint->low, footprint->high, position);
+
+    if (pointer->low < -extent - footprint->low) {
+        pointer->low = -extent - footprint->low;
+    }
+
+    if (pointer->high > extent - 1 - footprint->high) {
+        pointer->high = extent - 1 - footprint->high;
+    }
+}
+
+/* Copies [first, last) into the result with checks in between.  The region
+ * is a sequence of blocks of cell opcodes and moves, each ended by a branch,
+ * a scan or the end of the program, and a block is checked along with the
+ * cell its branch or scan reads. */
+static void check_region(struct range_analysis *analysis, size_t first,
+    size_t last, struct tape_range *pointer)
+{
+    struct opcode const *opcodes = analysis->program->opcodes;
+
+    long extent = analysis->extent;
+    size_t size = analysis->program->options.cell_width / 8;
+
+    size_t i = first;
+
+    while (i != last) {
+        struct tape_range footprint = {LONG_MAX, LONG_MIN};
+        struct opcode const *end = NULL;
+
+        size_t j = i;
+        long shift = 0;
+
+        for (; j != last; ++j) {
+            struct opcode const *opcode = opcodes + j;
+
+            if (opcode->instruction == B_MOVE_POINTER_LEFT) {
+                shift -= (long) opcode->auxiliary;
+            } else if (opcode->instruction == B_MOVE_POINTER_RIGHT) {
+                shift += (long) opcode->auxiliary;
+            } else if (is_cell_instruction(opcode->instruction)) {
+                extend_range(&footprint, shift + opcode->offset,
+                    shift + opcode->offset);
+
+                if (opcode->instruction == B_MULTIPLY_CELL_VALUE) {
+                    extend_range(&footprint, shift + opcode->source,
+                        shift + opcode->source);
+                }
+            } else if (opcode->instruction != B_OUTPUT_CONSTANT) {
+                break;
+            }
+        }
+
+        end = (j != last) ? opcodes + j : NULL;
+
+        if (end != NULL && end->instruction == B_BRANCH_FORWARD &&
+            is_invariant_loop(analysis, j)) {
+            extend_range(&footprint, shift + analysis->footprints[j].low,
+                shift + analysis->footprints[j].high);
+        } else if (end != NULL && end->instruction != B_TERMINATE) {
+            extend_range(&footprint, shift, shift);
+        }
+
+        guard_footprint(analysis, pointer, &footprint, opcodes[i].position);
+        copy_opcodes(analysis, i, j);
+
+        pointer->low += shift;
+        pointer->high += shift;
+
+        if (end == NULL) {
+            break;
+        }
+
+        i = j + 1;
+
+        switch (end->instruction) {
+        case B_BRANCH_FORWARD:
+            i = end->auxiliary + 1;
+
+            if (analysis->invariance[j] > 0) {
+                copy_opcodes(analysis, j, i);
+                break;
+            }
+
+            /* Wherever an iteration leaves the pointer, the `]` has read
+             * the cell under it, so the tape is all that is known. */
+            pointer->low = -extent;
+            pointer->high = extent - 1;
+
+            copy_opcodes(analysis, j, j + 1);
+            check_region(analysis, j + 1, i, pointer);
+
+            pointer->low = -extent;
+            pointer->high = extent - 1;
+            break;
+
+        case B_SCAN_LEFT:
+        case B_SCAN_RIGHT: {
+            long stride = (long) end->auxiliary;
+
+            if (end->auxiliary * size <= B_MINIMUM_GUARD_LENGTH) {
+                copy_opcodes(analysis, j, i);
+            } else {
+                struct opcode *loop = NULL;
+
+                if (end->instruction == B_SCAN_LEFT) {
+                    stride = -stride;
+                }
+
+                loop = analysis->result + analysis->length;
+                loop[0] = *end;
+                loop[0].instruction = B_BRANCH_FORWARD;
+                analysis->length += 1;
+
+                emit_tape_check(analysis, stride, stride, end->position);
+
+                loop = analysis->result + analysis->length;
+                loop[0] = *end;
+                loop[0].instruction = (stride < 0) ? B_MOVE_POINTER_LEFT
+                                                   : B_MOVE_POINTER_RIGHT;
+                loop[1] = *end;
+                loop[1].instruction = B_BRANCH_BACKWARD;
+                analysis->length += 2;
+            }
+
+            if (end->instruction == B_SCAN_LEFT) {
+                pointer->low = -extent;
+            } else {
+                pointer->high = extent - 1;
+            }
+
+            break;
+        }
+
+        default:
+            copy_opcodes(analysis, j, i);
+            break;
+        }
+    }
+}
+
+/* Rewrites the program with its tape checks in place, and links it
+ * again. */
+static enum brainfuck_status insert_tape_checks(
+    struct program *program, size_t *number_of_checks)
+{
+    struct range_analysis analysis;
+    struct tape_range pointer = {0, 0};
+
+    struct opcode *opcodes = NULL;
+    size_t length = program->number_of_opcodes;
+
+    analysis.program = program;
+    analysis.extent =
+        (long) (B_TAPE_EXTENT / (program->options.cell_width / 8));
+
+    analysis.invariance = calloc(length, sizeof(signed char));
+    analysis.footprints = malloc(sizeof(struct tape_range) * length);
+
+    /* A check per block, and an expanded scan takes four opcodes. */
+    analysis.result = malloc(sizeof(struct opcode) * length * 5);
+    analysis.length = 0;
+    analysis.number_of_checks = 0;
+
+    if (analysis.invariance == NULL || analysis.footprints == NULL ||
+        analysis.result == NULL) {
+        free(analysis.invariance);
+        free(analysis.footprints);
+        free(analysis.result);
+
+        return B_OUT_OF_MEMORY;
+    }
+
+    check_region(&analysis, 0, length, &pointer);
+
+    free(analysis.invariance);
+    free(analysis.footprints);
+
+    opcodes = realloc(
+        analysis.result, sizeof(struct opcode) * analysis.length);
+
+    free(program->opcodes);
+
+    program->opcodes = (opcodes != NULL) ? opcodes : analysis.result;
+    program->number_of_opcodes = analysis.length;
+
+    *number_of_checks = analysis.number_of_checks;
+    return link_branches(program);
+}
+
+/* The program run while it is compiled, on a window of cells with the first
+ * one in the middle.  Whatever it does up to its first input is folded into
+ * the program: the output it wrote becomes a single constant write and the
+ * cells it left behind a run of sets, ahead of the opcodes still to run. */
+struct evaluation {
+    struct program const *program;
+
+    uint64_t *cells;
+    long pointer;
+
+    unsigned char *output;
+    size_t output_length;
+
+    uint64_t steps;
+    size_t depth;
+};
+
+static inline uint64_t *find_evaluated_cell(
+    struct evaluation *evaluation, long offset)
+{
+    long index = evaluation->pointer + offset;
+
+    if (index < -B_EVALUATION_WINDOW / 2 || index >= B_EVALUATION_WINDOW / 2) {
+        return NULL;
+    }
+
+    return evaluation->cells + B_EVALUATION_WINDOW / 2 + index;
+}
+
+/* Runs the program from the start until it wants input or terminates, has
+ * run `budget` opcodes, leaves the window or writes too much, or is about
+ * to run `stop` outside of any loop.  Returns the last opcode it got to
+ * outside of any loop, which is the only kind of place a run can pick up
+ * from. */
+static size_t evaluate(
+    struct evaluation *evaluation, uint64_t budget, size_t stop)
+{
+    struct opcode const *opcodes = evaluation->program->opcodes;
+    size_t mask = get_cell_mask(evaluation->program);
+
+    size_t i = 0;
+    size_t resume = 0;
+
+    uint64_t steps = 0;
+
+    evaluation->depth = 0;
+
+    for (;; ++i, ++steps) {
+        struct opcode const *opcode = opcodes + i;
+
+        uint64_t *cell = NULL;
+        uint64_t *source = NULL;
+
+        long pointer = evaluation->pointer;
+
+        if (evaluation->depth == 0) {
+            resume = i;
+            evaluation->steps = steps;
+
+            if (i == stop) {
+                return resume;
+            }
+        }
+
+        if (steps == budget) {
+            return resume;
+        }
+
+        switch (opcode->instruction) {
+        case B_MOVE_POINTER_LEFT:
+            evaluation->pointer -= (long) opcode->auxiliary;
+            continue;
+
+        case B_MOVE_POINTER_RIGHT:
+            evaluation->pointer += (long) opcode->auxiliary;
+            continue;
+
+        case B_SCAN_LEFT:
+        case B_SCAN_RIGHT:
+            while ((cell = find_evaluated_cell(evaluation, 0)) != NULL &&
+                *cell != 0 && steps != budget) {
+                evaluation->pointer += (opcode->instruction == B_SCAN_LEFT)
+                    ? -(long) opcode->auxiliary
+                    : (long) opcode->auxiliary;
+                ++steps;
+            }
+
+            if (cell == NULL || *cell != 0) {
+                evaluation->pointer = pointer;
+                return resume;
+            }
+
+            continue;
+
+        case B_INPUT_CELL_VALUE:
+        case B_TERMINATE:
+            return resume;
+
+        default:
+            break;
+        }
+
+        cell = find_evaluated_cell(evaluation,
+            is_cell_instruction(opcode->instruction) ? opcode->offset : 0);
+
+        if (cell == NULL) {
+            return resume;
+        }
+
+        switch (opcode->instruction) {
+        case B_INCREMENT_CELL_VALUE:
+            *cell = (*cell + opcode->auxiliary) & mask;
+            break;
+
+        case B_DECREMENT_CELL_VALUE:
+            *cell = (*cell - opcode->auxiliary) & mask;
+            break;
+
+        case B_SET_CELL_VALUE:
+            *cell = opcode->auxiliary & mask;
+            break;
+
+        case B_MULTIPLY_CELL_VALUE:
+            if ((source = find_evaluated_cell(evaluation, opcode->source)) ==
+                NULL) {
+                return resume;
+            }
+
+            *cell = (*cell + *source * opcode->auxiliary) & mask;
+            break;
+
+        case B_OUTPUT_CELL_VALUE:
+            if (opcode->auxiliary >
+                B_EVALUATION_OUTPUT_LIMIT - evaluation->output_length) {
+                return resume;
+            }
+
+            memset(evaluation->output + evaluation->output_length,
+                (unsigned char) *cell, opcode->auxiliary);
+            evaluation->output_length += opcode->auxiliary;
+            break;
+
+        case B_BRANCH_FORWARD:
+            if (*cell == 0) {
+                i = opcode->auxiliary;
+            } else {
+                ++(evaluation->depth);
+            }
+
+            break;
+
+        case B_BRANCH_BACKWARD:
+            if (*cell != 0) {
+                i = opcode->auxiliary;
+            } else {
+                --(evaluation->depth);
+            }
+
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+static void reset_evaluation(struct evaluation *evaluation)
+{
+    memset(evaluation->cells, 0, sizeof(uint64_t) * B_EVALUATION_WINDOW);
+
+    evaluation->pointer = 0;
+    evaluation->output_length = 0;
+}
+
+/* A run that stopped inside a loop has gone past the place the rest of the
+ * program can pick up from, so it is run again from scratch up to there. */
+static enum brainfuck_status evaluate_prefix(
+    struct program *program, struct brainfuck_statistics *statistics)
+{
+    struct evaluation evaluation;
+    struct opcode *opcodes = NULL;
+
+    size_t resume = 0;
+    size_t length = 0;
+    size_t i = 0;
+
+    int has_terminated = B_FALSE;
+
+    if (program->options.evaluation_budget == 0) {
+        return B_SUCCESS;
+    }
+
+    evaluation.program = program;
+    evaluation.cells = malloc(sizeof(uint64_t) * B_EVALUATION_WINDOW);
+    evaluation.output = malloc(B_EVALUATION_OUTPUT_LIMIT);
+
+    if (evaluation.cells == NULL || evaluation.output == NULL) {
+        free(evaluation.cells);
+        free(evaluation.output);
+
+        return B_OUT_OF_MEMORY;
+    }
+
+    reset_evaluation(&evaluation);
+    resume = evaluate(&evaluation, program->options.evaluation_budget,
+        program->number_of_opcodes);
+
+    if (resume != 0 && evaluation.depth != 0) {
+        reset_evaluation(&evaluation);
+        evaluate(&evaluation, UINT64_MAX, resume);
+    }
+
+    has_terminated = program->opcodes[resume].instruction == B_TERMINATE;
+    length = (evaluation.output_length != 0) + 1 +
+        program->number_of_opcodes - resume;
+
+    for (; !has_terminated && i != (size_t) B_EVALUATION_WINDOW; ++i) {
+        length += (evaluation.cells[i] != 0);
+    }
+
+    if (resume == 0 ||
+        (opcodes = malloc(sizeof(struct opcode) * length)) == NULL) {
+        free(evaluation.cells);
+        free(evaluation.output);
+
+        return (resume == 0) ? B_SUCCESS : B_OUT_OF_MEMORY;
+    }
+
+    length = 0;
+
+    if (evaluation.output_length != 0) {
+        struct opcode opcode = {B_OUTPUT_CONSTANT, 0, 0, 0, 0};
+
+        opcode.auxiliary = evaluation.output_length;
+        opcodes[length++] = opcode;
+    }
+
+    for (i = 0; !has_terminated && i != (size_t) B_EVALUATION_WINDOW; ++i) {
+        struct opcode opcode = {B_SET_CELL_VALUE, 0, 0, 0, 0};
+
+        if (evaluation.cells[i] != 0) {
+            opcode.auxiliary = evaluation.cells[i];
+            opcode.offset = (long) i - B_EVALUATION_WINDOW / 2;
+            opcodes[length++] = opcode;
+        }
+    }
+
+    if (!has_terminated && evaluation.pointer != 0) {
+        struct opcode opcode = {B_MOVE_POINTER_RIGHT, 0, 0, 0, 0};
+
+        if (evaluation.pointer < 0) {
+            opcode.instruction = B_MOVE_POINTER_LEFT;
+        }
+
+        opcode.auxiliary = labs(evaluation.pointer);
+        opcodes[length++] = opcode;
+    }
+
+    memcpy(opcodes + length, program->opcodes + resume,
+        sizeof(struct opcode) * (program->number_of_opcodes - resume));
+    length += program->number_of_opcodes - resume;
+
+    free(evaluation.cells);
+    free(program->opcodes);
+
+    program->opcodes = opcodes;
+    program->number_of_opcodes = length;
+
+    if (evaluation.output_length != 0) {
+        program->constants =
+            realloc(evaluation.output, evaluation.output_length);
+        program->constants_length = evaluation.output_length;
+
+        if (program->constants == NULL) {
+            program->constants = evaluation.output;
+        }
+    } else {
+        free(evaluation.output);
+    }
+
+    statistics->number_of_evaluated_opcodes = evaluation.steps;
+    statistics->evaluated_output_length = evaluation.output_length;
+
+    return link_branches(program);
+}
+
+/* Pairs of opcodes that the threaded and compact interpreters run with a
+ * single dispatch, picked from the pairs that `-p` reports as hottest across
+ * the examples.  The codes are instruction bytes no opcode uses; in bytecode,
+ * the first word of a pair carries one in place of its own instruction. */
+enum superinstruction_code {
+    B_MULTIPLY_MULTIPLY = 0x01,
+    B_MULTIPLY_SET,
+    B_SET_MULTIPLY,
+    B_SET_SET,
+    B_SET_DECREMENT,
+    B_SET_MOVE_LEFT,
+    B_SET_MOVE_RIGHT,
+    B_SET_BRANCH_BACKWARD,
+    B_DECREMENT_BRANCH_BACKWARD,
+    B_MOVE_LEFT_BRANCH_BACKWARD,
+    B_MOVE_RIGHT_BRANCH_BACKWARD,
+    B_MOVE_RIGHT_BRANCH_FORWARD,
+    B_NUMBER_OF_SUPERINSTRUCTIONS
+};
+
+struct superinstruction {
+    enum instruction first;
+    enum instruction second;
+    char const *name;
+};
+
+static struct superinstruction const
+    B_SUPERINSTRUCTIONS[B_NUMBER_OF_SUPERINSTRUCTIONS] = {
+        [B_MULTIPLY_MULTIPLY] = {B_MULTIPLY_CELL_VALUE, B_MULTIPLY_CELL_VALUE,
+            "multiply-multiply"},
+        [B_MULTIPLY_SET] = {B_MULTIPLY_CELL_VALUE, B_SET_CELL_VALUE,
+            "multiply-set"},
+        [B_SET_MULTIPLY] = {B_SET_CELL_VALUE, B_MULTIPLY_CELL_VALUE,
+            "set-multiply"},
+        [B_SET_SET] = {B_SET_CELL_VALUE, B_SET_CELL_VALUE, "set-set"},
+        [B_SET_DECREMENT] = {B_SET_CELL_VALUE, B_DECREMENT_CELL_VALUE,
+            "set-decrement"},
+        [B_SET_MOVE_LEFT] = {B_SET_CELL_VALUE, B_MOVE_POINTER_LEFT,
+            "set-move-left"},
+        [B_SET_MOVE_RIGHT] = {B_SET_CELL_VALUE, B_MOVE_POINTER_RIGHT,
+            "set-move-right"},
+        [B_SET_BRANCH_BACKWARD] = {B_SET_CELL_VALUE, B_BRANCH_BACKWARD,
+            "set-branch-back"},
+        [B_DECREMENT_BRANCH_BACKWARD] = {B_DECREMENT_CELL_VALUE,
+            B_BRANCH_BACKWARD, "decrement-branch-back"},
+        [B_MOVE_LEFT_BRANCH_BACKWARD] = {B_MOVE_POINTER_LEFT,
+            B_BRANCH_BACKWARD, "move-left-branch-back"},
+        [B_MOVE_RIGHT_BRANCH_BACKWARD] = {B_MOVE_POINTER_RIGHT,
+            B_BRANCH_BACKWARD, "move-right-branch-back"},
+        [B_MOVE_RIGHT_BRANCH_FORWARD] = {B_MOVE_POINTER_RIGHT,
+            B_BRANCH_FORWARD, "move-right-branch"}};
+
+/* Returns the code of the superinstruction for the pair, or 0 if there is
+ * none. */
+static unsigned int find_superinstruction(
+    enum instruction first, enum instruction second)
+{
+    unsigned int code = 1;
+
+    for (; code != B_NUMBER_OF_SUPERINSTRUCTIONS; ++code) {
+        if (B_SUPERINSTRUCTIONS[code].first == first &&
+            B_SUPERINSTRUCTIONS[code].second == second) {
+            return code;
+        }
+    }
+
+    return 0;
+}
+
+/* Names an instruction the way the superinstructions name their halves. */
+static char const *get_instruction_name(enum instruction instruction)
+{
+    switch (instruction) {
+    case B_MOVE_POINTER_LEFT:
+        return "move-left";
+    case B_MOVE_POINTER_RIGHT:
+        return "move-right";
+    case B_INCREMENT_CELL_VALUE:
+        return "increment";
+    case B_DECREMENT_CELL_VALUE:
+        return "decrement";
+    case B_OUTPUT_CELL_VALUE:
+        return "output";
+    case B_INPUT_CELL_VALUE:
+        return "input";
+    case B_BRANCH_FORWARD:
+        return "branch";
+    case B_BRANCH_BACKWARD:
+        return "branch-back";
+    case B_SET_CELL_VALUE:
+        return "set";
+    case B_MULTIPLY_CELL_VALUE:
+        return "multiply";
+    case B_SCAN_LEFT:
+        return "scan-left";
+    case B_SCAN_RIGHT:
+        return "scan-right";
+    case B_CHECK_TAPE:
+        return "check-tape";
+    case B_OUTPUT_CONSTANT:
+        return "constant";
+    case B_TERMINATE:
+        return "terminate";
+    default:
+        return "~";
+    }
+}
+
+static inline int is_compact_opcode(struct opcode const *opcode)
+{
+    switch (opcode->instruction) {
+    case B_INCREMENT_CELL_VALUE:
+    case B_DECREMENT_CELL_VALUE:
+    case B_OUTPUT_CELL_VALUE:
+    case B_INPUT_CELL_VALUE:
+    case B_SET_CELL_VALUE:
+        return opcode->auxiliary <= 0xFF && opcode->offset >= INT16_MIN &&
+            opcode->offset <= INT16_MAX;
+
+    case B_MULTIPLY_CELL_VALUE:
+    case B_CHECK_TAPE:
+        return opcode->auxiliary <= 0xFF && opcode->offset >= INT8_MIN &&
+            opcode->offset <= INT8_MAX && opcode->source >= INT8_MIN &&
+            opcode->source <= INT8_MAX;
+
+    case B_MOVE_POINTER_LEFT:
+    case B_MOVE_POINTER_RIGHT:
+    case B_SCAN_LEFT:
+    case B_SCAN_RIGHT:
+    case B_BRANCH_FORWARD:
+    case B_BRANCH_BACKWARD:
+        return opcode->auxiliary <= B_MAXIMUM_PAYLOAD;
+
+    case B_OUTPUT_CONSTANT:
+        return B_FALSE;
+
+    default:
+        return B_TRUE;
+    }
+}
+
+static inline uint32_t encode_opcode(struct opcode const *opcode)
+{
+    uint32_t word = (uint32_t) opcode->instruction & 0xFF;
+
+    switch (opcode->instruction) {
+    case B_INCREMENT_CELL_VALUE:
+    case B_DECREMENT_CELL_VALUE:
+    case B_OUTPUT_CELL_VALUE:
+    case B_INPUT_CELL_VALUE:
+    case B_SET_CELL_VALUE:
+        return word | (uint32_t) opcode->auxiliary << 8 |
+            (uint32_t) (uint16_t) opcode->offset << 16;
+
+    case B_MULTIPLY_CELL_VALUE:
+    case B_CHECK_TAPE:
+        return word | (uint32_t) opcode->auxiliary << 8 |
+            (uint32_t) (uint8_t) opcode->offset << 16 |
+            (uint32_t) (uint8_t) opcode->source << 24;
+
+    case B_MOVE_POINTER_LEFT:
+    case B_MOVE_POINTER_RIGHT:
+    case B_SCAN_LEFT:
+    case B_SCAN_RIGHT:
+    case B_BRANCH_FORWARD:
+    case B_BRANCH_BACKWARD:
+        return word | (uint32_t) opcode->auxiliary << 8;
+
+    default:
+        return word;
+    }
+}
+
+static inline void free_bytecode(struct bytecode *bytecode)
+{
+    if (bytecode != NULL) {
+        free(bytecode->words);
+        free(bytecode->operands);
+    }
+
+    free(bytecode);
+}
+
+static enum brainfuck_status encode_program(
+    struct program const *program, struct bytecode **result)
+{
+    size_t i = 0;
+
+    struct bytecode *bytecode = NULL;
+
+    if (program == NULL || program->opcodes == NULL) {
+        abort();
+    }
+
+    bytecode = calloc(1, sizeof(struct bytecode));
+
+    if (bytecode == NULL) {
+        return B_OUT_OF_MEMORY;
+    }
+
+    bytecode->number_of_words = program->number_of_opcodes;
+    bytecode->number_of_operands = 0;
+    bytecode->constants = program->constants;
+
+    for (; i != program->number_of_opcodes; ++i) {
+        if (!is_compact_opcode(program->opcodes + i)) {
+            ++(bytecode->number_of_operands);
+        }
+    }
+
+    if (bytecode->number_of_operands > B_MAXIMUM_PAYLOAD) {
+        free(bytecode);
+        return B_PROGRAM_TOO_LARGE;
+    }
+
+    bytecode->words = malloc(sizeof(uint32_t) * bytecode->number_of_words);
+    bytecode->operands =
+        malloc(sizeof(struct opcode) * (bytecode->number_of_operands + 1));
+
+    if (bytecode->words == NULL || bytecode->operands == NULL) {
+        free_bytecode(bytecode);
+        return B_OUT_OF_MEMORY;
+    }
+
+    bytecode->number_of_operands = 0;
+
+    for (i = 0; i != program->number_of_opcodes; ++i) {
+        struct opcode const *opcode = program->opcodes + i;
+
+        if (is_compact_opcode(opcode)) {
+            bytecode->words[i] = encode_opcode(opcode);
+            continue;
+        }
+
+        bytecode->words[i] =
+            ((uint32_t) opcode->instruction | B_WIDE_OPCODE) |
+            (uint32_t) bytecode->number_of_operands << 8;
+
+        bytecode->operands[bytecode->number_of_operands++] = *opcode;
+    }
+
+    /* Going forward, the second word of a pair still has its own instruction
+     * when the pair is looked at, so pairs can overlap. */
+    for (i = 0; program->options.should_optimize == B_TRUE &&
+         i + 1 < program->number_of_opcodes;
+         ++i) {
+        unsigned int code = find_superinstruction(
+            program->opcodes[i].instruction,
+            program->opcodes[i + 1].instruction);
+
+        if (code != 0 && (bytecode->words[i] & B_WIDE_OPCODE) == 0 &&
+            (bytecode->words[i + 1] & B_WIDE_OPCODE) == 0) {
+            bytecode->words[i] = (bytecode->words[i] & ~0xFFU) | code;
+        }
+    }
+
+    *result = bytecode;
+    return B_SUCCESS;
+}
+
+static void decode_opcode(
+    struct bytecode const *bytecode, size_t i, struct opcode *opcode)
+{
+    uint32_t word = bytecode->words[i];
+
+    if ((word & B_WIDE_OPCODE) != 0 && (word & 0xFF) != B_TERMINATE) {
+        *opcode = bytecode->operands[word >> 8];
+        return;
+    }
+
+    opcode->instruction = word & 0xFF;
+    opcode->position = 0;
+
+    if ((word & 0xFF) < B_NUMBER_OF_SUPERINSTRUCTIONS) {
+        opcode->instruction = B_SUPERINSTRUCTIONS[word & 0xFF].first;
+    }
+
+    opcode->auxiliary = 0;
+    opcode->offset = 0;
+    opcode->source = 0;
+
+    switch (opcode->instruction) {
+    case B_INCREMENT_CELL_VALUE:
+    case B_DECREMENT_CELL_VALUE:
+    case B_OUTPUT_CELL_VALUE:
+    case B_INPUT_CELL_VALUE:
+    case B_SET_CELL_VALUE:
+        opcode->auxiliary = (word >> 8) & 0xFF;
+        opcode->offset = (int16_t) (word >> 16);
+        break;
+
+    case B_MULTIPLY_CELL_VALUE:
+    case B_CHECK_TAPE:
+        opcode->auxiliary = (word >> 8) & 0xFF;
+        opcode->offset = (int8_t) (word >> 16);
+        opcode->source = (int8_t) (word >> 24);
+        break;
+
+    case B_MOVE_POINTER_LEFT:
+    case B_MOVE_POINTER_RIGHT:
+    case B_SCAN_LEFT:
+    case B_SCAN_RIGHT:
+    case B_BRANCH_FORWARD:
+    case B_BRANCH_BACKWARD:
+        opcode->auxiliary = word >> 8;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Selects the cells of a vector that lie on the stride, one bit per byte
+ * like `_mm_movemask_epi8`: the lowest byte of each cell when scanning right
+ * and the highest one when scanning left. */
+static inline unsigned int get_stride_mask(
+    size_t stride, size_t size, int is_reversed)
+{
+    size_t i = 0;
+    size_t lanes = B_VECTOR_WIDTH / size;
+
+    unsigned int mask = 0;
+
+    for (; i < lanes - lanes % stride; i += stride) {
+        mask |= 1U << (is_reversed ? B_VECTOR_WIDTH - 1 - i * size : i * size);
+    }
+
+    return mask;
+}
+
+/* A tape is a reservation of `B_TAPE_EXTENT` bytes on either side of its
+ * first cell, mapped without access and fenced off by a guard granule at both
+ * ends.  Only the length it is created with is committed up front; touching
+ * anything else in the reservation faults, and the handler commits the pages
+ * in between, at least doubling the committed range each time.  Whatever a
+ * run grows it by is given back once the run is over. */
+struct brainfuck_tape {
+    char *reservation;
+    size_t reservation_length;
+    size_t granule;
+
+    char *begin;
+    char *end;
+    char *origin;
+
+    char *committed_begin;
+    char *committed_end;
+    char *initial_end;
+
+    /* How much the run under way may commit, if it is limited. */
+    size_t limit;
+
+    int is_dirty;
+};
+
+/* Everything a run needs while it is under way.  The runtime functions are
+ * called from generated code that knows nothing about runs, so they find
+ * theirs through a thread-local pointer, and so does the fault handler.
+ * Running out of tape, input or output that fails, all jump straight back to
+ * where the run started. */
+struct run {
+    struct program const *program;
+    struct brainfuck_tape *tape;
+    struct brainfuck_io const *io;
+
+    char output[B_OUTPUT_BUFFER_LENGTH];
+    size_t output_length;
+
+    unsigned char input[B_INPUT_BUFFER_LENGTH];
+    unsigned char const *input_cursor;
+    unsigned char const *input_end;
+
+    struct tier *tier;
+    struct profile *profile;
+    void **handlers;
+
+    uint64_t step_limit;
+
+    int generation;
+    int has_timer;
+    timer_t timer;
+
+    volatile sig_atomic_t is_deferring_timeout;
+    volatile sig_atomic_t is_timed_out;
+
+    sigjmp_buf exit;
+};
+
+static _Thread_local struct run *B_RUN = NULL;
+static _Thread_local int B_RUN_GENERATION = 0;
+
+static pthread_once_t B_FAULT_HANDLER_ONCE = PTHREAD_ONCE_INIT;
+static pthread_once_t B_TIMEOUT_HANDLER_ONCE = PTHREAD_ONCE_INIT;
+static struct sigaction B_PREVIOUS_FAULT_HANDLER;
+static char B_FAULT_STACK[B_FAULT_STACK_LENGTH];
+
+static int commit_tape(struct brainfuck_tape *tape, char *address)
+{
+    char *begin = tape->committed_begin;
+    char *end = tape->committed_end;
+
+    size_t length = end - begin;
+
+    if (address < tape->begin || address >= tape->end) {
+        return B_FALSE;
+    }
+
+    if (address < begin) {
+        begin = (char *) ((uintptr_t) address & ~(tape->granule - 1));
+
+        if ((size_t) (tape->committed_begin - tape->begin) <= length) {
+            begin = tape->begin;
+        } else if (begin > tape->committed_begin - length) {
+            begin = tape->committed_begin - length;
+        }
+    } else if (address >= end) {
+        end = (char *) (((uintptr_t) address + tape->granule) &
+            ~(tape->granule - 1));
+
+        if ((size_t) (tape->end - tape->committed_end) <= length) {
+            end = tape->end;
+        } else if (end < tape->committed_end + length) {
+            end = tape->committed_end + length;
+        }
+    } else {
+        return B_FALSE;
+    }
+
+    /* Past the limit, the tape grows only as far as the limit allows. */
+    if (tape->limit != 0 && (size_t) (end - begin) > tape->limit) {
+        if (length >= tape->limit) {
+            return B_FALSE;
+        }
+
+        if (address < tape->committed_begin) {
+            begin = end - tape->limit;
+        } else {
+            end = begin + tape->limit;
+        }
+
+        if (address < begin || address >= end) {
+            return B_FALSE;
+        }
+    }
+
+    if (mprotect(begin, end - begin, PROT_READ | PROT_WRITE) != 0) {
+        return B_FALSE;
+    }
+
+    tape->committed_begin = begin;
+    tape->committed_end = end;
+
+    return B_TRUE;
+}
+
+static void handle_tape_fault(
+    int number, siginfo_t *information, void *context)
+{
+    char *address = information->si_addr;
+
+    struct run *run = B_RUN;
+    struct brainfuck_tape *tape = (run != NULL) ? run->tape : NULL;
+
+    (void) number;
+    (void) context;
+
+    if (tape != NULL && commit_tape(tape, address) == B_TRUE) {
+        return;
+    }
+
+    if (tape != NULL && address >= tape->reservation &&
+        address < tape->reservation + tape->reservation_length) {
+        siglongjmp(run->exit, B_TAPE_EXHAUSTED);
+    }
+
+    /* Returning re-raises the fault under whatever was there before. */
+    sigaction(SIGSEGV, &B_PREVIOUS_FAULT_HANDLER, NULL);
+}
+
+/* The alternate stack only belongs to the thread that installs the handler,
+ * and is left alone when that thread already has one. */
+static void install_fault_handler(void)
+{
+    struct sigaction action;
+    stack_t stack;
+
+    if (sigaltstack(NULL, &stack) == 0 && (stack.ss_flags & SS_DISABLE)) {
+        stack.ss_sp = B_FAULT_STACK;
+        stack.ss_size = B_FAULT_STACK_LENGTH;
+        stack.ss_flags = 0;
+
+        sigaltstack(&stack, NULL);
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = handle_tape_fault;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+
+    sigaction(SIGSEGV, &action, &B_PREVIOUS_FAULT_HANDLER);
+}
+
+/* A timeout jumps out of the run right away, unless the run is in the
+ * caller's callbacks or holds a lock.  Then it waits until the run is back.
+ * The generation tells a late signal from an earlier run apart. */
+static void handle_timeout(int number, siginfo_t *information, void *context)
+{
+    struct run *run = B_RUN;
+
+    (void) number;
+    (void) context;
+
+    if (run == NULL || information->si_value.sival_int != run->generation) {
+        return;
+    }
+
+    run->is_timed_out = B_TRUE;
+
+    if (run->is_deferring_timeout == B_FALSE) {
+        siglongjmp(run->exit, B_TIMED_OUT);
+    }
+}
+
+static void install_timeout_handler(void)
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = handle_timeout;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+
+    sigaction(B_TIMEOUT_SIGNAL, &action, NULL);
+}
+
+static inline void defer_timeout(struct run *run)
+{
+    if (run != NULL) {
+        run->is_deferring_timeout = B_TRUE;
+    }
+}
+
+static inline void resume_timeout(struct run *run)
+{
+    if (run != NULL) {
+        run->is_deferring_timeout = B_FALSE;
+
+        if (run->is_timed_out == B_TRUE) {
+            siglongjmp(run->exit, B_TIMED_OUT);
+        }
+    }
+}
+
+/* The timer counts wall-clock time and signals the thread doing the run. */
+static enum brainfuck_status start_timer(struct run *run, double seconds)
+{
+    struct sigevent event;
+    struct itimerspec timeout;
+
+    pthread_once(&B_TIMEOUT_HANDLER_ONCE, install_timeout_handler);
+
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = B_TIMEOUT_SIGNAL;
+    event.sigev_value.sival_int = run->generation;
+    event.sigev_notify_thread_id = gettid();
+
+    memset(&timeout, 0, sizeof(timeout));
+    timeout.it_value.tv_sec = (time_t) seconds;
+    timeout.it_value.tv_nsec =
+        (long) ((seconds - timeout.it_value.tv_sec) * 1e9);
+
+    if (timeout.it_value.tv_sec == 0 && timeout.it_value.tv_nsec == 0) {
+        timeout.it_value.tv_nsec = 1;
+    }
+
+    if (timer_create(CLOCK_MONOTONIC, &event, &run->timer) != 0) {
+        return B_OUT_OF_MEMORY;
+    }
+
+    run->has_timer = B_TRUE;
+
+    if (timer_settime(run->timer, 0, &timeout, NULL) != 0) {
+        timer_delete(run->timer);
+        run->has_timer = B_FALSE;
+
+        return B_OUT_OF_MEMORY;
+    }
+
+    return B_SUCCESS;
+}
+
+static void decommit_tape(char *begin, char *end)
+{
+    if (begin != end) {
+        madvise(begin, end - begin, MADV_DONTNEED);
+        mprotect(begin, end - begin, PROT_NONE);
+    }
+}
+
+/* Shrinks the tape back to the length it was created with, so that a tape
+ * reused for many runs holds on to no more than that in between. */
+static void shrink_tape(struct brainfuck_tape *tape)
+{
+    decommit_tape(tape->committed_begin, tape->origin);
+    decommit_tape(tape->initial_end, tape->committed_end);
+
+    tape->committed_begin = tape->origin;
+    tape->committed_end = tape->initial_end;
+}
+
+void brainfuck_destroy_tape(struct brainfuck_tape *tape)
+{
+    if (tape != NULL) {
+        munmap(tape->reservation, tape->reservation_length);
+    }
+
+    free(tape);
+}
+
+enum brainfuck_status brainfuck_create_tape(size_t length,
+    int should_use_huge_pages, struct brainfuck_tape **result)
+{
+    struct brainfuck_tape *tape = calloc(1, sizeof(struct brainfuck_tape));
+
+    if (result == NULL) {
+        abort();
+    }
+
+    if (tape == NULL) {
+        return B_OUT_OF_MEMORY;
+    }
+
+    tape->granule = (should_use_huge_pages == B_TRUE)
+        ? B_HUGE_PAGE_LENGTH
+        : (size_t) sysconf(_SC_PAGESIZE);
+
+    tape->reservation_length = 2 * B_TAPE_EXTENT + 3 * tape->granule;
+    tape->reservation = mmap(NULL, tape->reservation_length, PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (tape->reservation == MAP_FAILED) {
+        free(tape);
+        return B_OUT_OF_MEMORY;
+    }
+
+    /* One spare granule keeps the first cell aligned for huge pages. */
+    tape->origin = (char *) (((uintptr_t) tape->reservation + tape->granule +
+                                 B_TAPE_EXTENT + tape->granule - 1) &
+        ~(tape->granule - 1));
+
+    tape->begin = tape->origin - B_TAPE_EXTENT;
+    tape->end = tape->origin + B_TAPE_EXTENT;
+
+#if defined(MADV_HUGEPAGE)
+    if (should_use_huge_pages == B_TRUE) {
+        madvise(tape->begin, tape->end - tape->begin, MADV_HUGEPAGE);
+    }
+#endif
+
+    pthread_once(&B_FAULT_HANDLER_ONCE, install_fault_handler);
+
+    tape->committed_begin = tape->origin;
+    tape->committed_end = tape->origin;
+
+    if (length > B_TAPE_EXTENT) {
+        length = B_TAPE_EXTENT;
+    }
+
+    if (length != 0 &&
+        commit_tape(tape, tape->origin + length - 1) == B_FALSE) {
+        brainfuck_destroy_tape(tape);
+        return B_OUT_OF_MEMORY;
+    }
+
+    tape->initial_end = tape->committed_end;
+
+    *result = tape;
+    return B_SUCCESS;
+}
+
+/* Generated code asks for its tape through these, and gets the one of the
+ * run it is part of. */
+static char *allocate_tape(size_t length)
+{
+    (void) length;
+
+    return B_RUN->tape->origin;
+}
+
+static void free_tape(char *tape)
+{
+    (void) tape;
+}
+
+/* Output is collected in the run and only handed to the write callback when
+ * the buffer fills up, before input is read and when the run ends.  The
+ * interpreters, the JIT'd code and the generated C code all write through the
+ * same three functions. */
+static void flush_output(void)
+{
+    struct run *run = B_RUN;
+    struct brainfuck_io const *io = run->io;
+
+    int result = 0;
+
+    if (run->output_length != 0 && io->write != NULL) {
+        defer_timeout(run);
+        result = io->write(io->context, (unsigned char const *) run->output,
+            run->output_length);
+        resume_timeout(run);
+    }
+
+    if (result != 0) {
+        siglongjmp(run->exit, B_CANNOT_WRITE);
+    }
+
+    run->output_length = 0;
+}
+
+static void write_output(int cell, size_t count)
+{
+    struct run *run = B_RUN;
+
+    while (count != 0) {
+        size_t length = B_OUTPUT_BUFFER_LENGTH - run->output_length;
+
+        if (length > count) {
+            length = count;
+        }
+
+        memset(run->output + run->output_length, cell, length);
+
+        run->output_length += length;
+        count -= length;
+
+        if (run->output_length == B_OUTPUT_BUFFER_LENGTH) {
+            flush_output();
+        }
+    }
+}
+
+/* Output worked out while compiling goes out in one piece, straight to the
+ * write callback unless it fits in what is left of the buffer. */
+static void write_constant(unsigned char const *bytes, size_t length)
+{
+    struct run *run = B_RUN;
+    struct brainfuck_io const *io = run->io;
+
+    int result = 0;
+
+    if (length <= B_OUTPUT_BUFFER_LENGTH - run->output_length) {
+        memcpy(run->output + run->output_length, bytes, length);
+        run->output_length += length;
+
+        return;
+    }
+
+    flush_output();
+
+    if (io->write != NULL) {
+        defer_timeout(run);
+        result = io->write(io->context, bytes, length);
+        resume_timeout(run);
+    }
+
+    if (result != 0) {
+        siglongjmp(run->exit, B_CANNOT_WRITE);
+    }
+}
+
+/* Input is read through a cursor: first over the input the caller handed
+ * in, then over blocks from the read callback.  Output is only flushed right
+ * before calling it. */
+static int refill_input(void)
+{
+    struct run *run = B_RUN;
+    struct brainfuck_io const *io = run->io;
+
+    ssize_t length = 0;
+
+    if (io->read == NULL) {
+        return B_FALSE;
+    }
+
+    flush_output();
+
+    defer_timeout(run);
+    length = io->read(io->context, run->input, B_INPUT_BUFFER_LENGTH);
+    resume_timeout(run);
+
+    if (length < 0) {
+        siglongjmp(run->exit, B_CANNOT_READ);
+    }
+
+    if (length == 0) {
+        return B_FALSE;
+    }
+
+    run->input_cursor = run->input;
+    run->input_end = run->input + length;
+
+    return B_TRUE;
+}
+
+static inline uint64_t read_input(uint64_t cell)
+{
+    struct run *run = B_RUN;
+
+    if (run->input_cursor == run->input_end && refill_input() == B_FALSE) {
+        struct brainfuck_options const *options = &run->program->options;
+
+        return (options->should_keep_cell_at_end_of_input == B_TRUE)
+            ? cell
+            : (uint64_t) options->end_of_input_value;
+    }
+
+    return *run->input_cursor++;
+}
+
+/* Where safe mode stops a run whose pointer left the tape, before any access
+ * could slip past the guard granule. */
+static void exhaust_tape(void)
+{
+    siglongjmp(B_RUN->exit, B_TAPE_EXHAUSTED);
+}
+
+static inline void check_tape(char const *low, char const *high)
+{
+    struct brainfuck_tape const *tape = B_RUN->tape;
+
+    if (low < tape->begin || high >= tape->end) {
+        exhaust_tape();
+    }
+}
+
+/* The scan kernels and the interpreters are instantiated once per cell
+ * width. */
+/* The tiered engine is the switch interpreter with a counter per loop.  A
+ * loop that runs hot is queued for compilation on a background thread, and
+ * once its native code is published the interpreter calls it the next time
+ * it reaches the loop's header, on the same tape. */
+typedef int32_t (*compiled_loop)(void *container, int32_t index);
+
+struct tier {
+    struct program const *program;
+
+    size_t *counters;
+    _Atomic(compiled_loop) *loops;
+
+    size_t *queue;
+    size_t head;
+    size_t tail;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    int is_stopping;
+
+    size_t number_of_compiled_loops;
+    double compilation_time;
+};
+
+static void request_compilation(struct tier *tier, size_t loop)
+{
+    defer_timeout(B_RUN);
+    pthread_mutex_lock(&tier->mutex);
+
+    tier->queue[tier->tail++] = loop;
+    pthread_cond_signal(&tier->condition);
+
+    pthread_mutex_unlock(&tier->mutex);
+    resume_timeout(B_RUN);
+}
+
+static inline compiled_loop find_compiled_loop(struct tier *tier, size_t loop)
+{
+    if (++tier->counters[loop] == B_HOT_LOOP_THRESHOLD) {
+        request_compilation(tier, loop);
+    }
+
+    return atomic_load_explicit(&tier->loops[loop], memory_order_acquire);
+}
+
+/* Counts per opcode, indexed like the program.  `successions` counts how
+ * often the next opcode ran right after this one.  Loops are kept under the
+ * index of their `[`: how often their body started and how many ticks of
+ * the time stamp counter went by between entering and leaving them. */
+struct profile {
+    uint64_t *executions;
+    uint64_t *successions;
+    uint64_t *iterations;
+    uint64_t *ticks;
+    uint64_t *started;
+
+    uint64_t total;
+};
+
+static inline uint64_t read_timestamp(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+#define B_CELL uint8_t
+#define B_INSTANCE(name) name##_8
+#include "interpreter.h"
+#undef B_INSTANCE
+#undef B_CELL
+
+#define B_CELL uint16_t
+#define B_INSTANCE(name) name##_16
+#include "interpreter.h"
+#undef B_INSTANCE
+#undef B_CELL
+
+#define B_CELL uint32_t
+#define B_INSTANCE(name) name##_32
+#include "interpreter.h"
+#undef B_INSTANCE
+#undef B_CELL
+
+#define B_CELL uint64_t
+#define B_INSTANCE(name) name##_64
+#include "interpreter.h"
+#undef B_INSTANCE
+#undef B_CELL
+
+struct interpreter {
+    uint64_t (*interpret)(struct program const *program, struct tier *tier,
+        uint64_t limit, char *tape);
+    void (*interpret_profiled)(struct program const *program,
+        struct profile *profile, uint64_t limit, char *tape);
+    void (*interpret_threaded)(
+        struct program const *program, char *tape, void **handlers);
+    void (*interpret_compact)(struct bytecode const *bytecode, char *tape);
+};
+
+static struct interpreter const B_INTERPRETERS[] = {
+    {interpret_8, interpret_profiled_8, interpret_threaded_8,
+        interpret_compact_8},
+    {interpret_16, interpret_profiled_16, interpret_threaded_16,
+        interpret_compact_16},
+    {interpret_32, interpret_profiled_32, interpret_threaded_32,
+        interpret_compact_32},
+    {interpret_64, interpret_profiled_64, interpret_threaded_64,
+        interpret_compact_64}};
+
+static inline struct interpreter const *get_interpreter(
+    struct program const *program)
+{
+    switch (program->options.cell_width) {
+    case 16:
+        return B_INTERPRETERS + 1;
+
+    case 32:
+        return B_INTERPRETERS + 2;
+
+    case 64:
+        return B_INTERPRETERS + 3;
+
+    default:
+        return B_INTERPRETERS;
+    }
+}
+
+static enum brainfuck_status check_llvm_error(LLVMErrorRef error)
+{
+    if (error == NULL) {
+        return B_SUCCESS;
+    }
+
+    LLVMConsumeError(error);
+    return B_COMPILATION_FAILED;
+}
+
+static pthread_once_t B_NATIVE_TARGET_ONCE = PTHREAD_ONCE_INIT;
+
+static void initialize_native_target(void)
+{
+    LLVMInitializeNativeTarget();
+    LLVMInitializeNativeAsmPrinter();
+}
+
+/* The optimizer, the JIT and the object files all target the machine we are
+ * running on, with all of its features.  Programs can be compiled on many
+ * threads at once, but the target is only registered once. */
+static LLVMTargetMachineRef create_target_machine(
+    struct program const *program, LLVMRelocMode relocation,
+    LLVMCodeModel model)
+{
+    static LLVMCodeGenOptLevel const levels[] = {LLVMCodeGenLevelNone,
+        LLVMCodeGenLevelLess, LLVMCodeGenLevelDefault,
+        LLVMCodeGenLevelAggressive};
+
+    LLVMTargetMachineRef machine = NULL;
+    LLVMTargetRef target = NULL;
+
+    char *triple = LLVMGetDefaultTargetTriple();
+    char *processor = LLVMGetHostCPUName();
+    char *features = LLVMGetHostCPUFeatures();
+    char *error = NULL;
+
+    pthread_once(&B_NATIVE_TARGET_ONCE, initialize_native_target);
+
+    if (LLVMGetTargetFromTriple(triple, &target, &error) == 0) {
+        machine = LLVMCreateTargetMachine(target, triple, processor, features,
+            levels[program->options.optimization_level], relocation, model);
+    }
+
+    LLVMDisposeMessage(error);
+    LLVMDisposeMessage(triple);
+    LLVMDisposeMessage(processor);
+    LLVMDisposeMessage(features);
+
+    return machine;
+}
+
+/* Consumes the module if it fails. */
+static LLVMModuleRef optimize_llvm_module(
+    struct program const *program, LLVMModuleRef module)
+{
+    LLVMTargetMachineRef machine = create_target_machine(
+        program, LLVMRelocDefault, LLVMCodeModelJITDefault);
+    LLVMPassBuilderOptionsRef options = NULL;
+    LLVMTargetDataRef layout = NULL;
+
+    char *triple = NULL;
+    char passes[16];
+
+    if (machine == NULL) {
+        LLVMDisposeModule(module);
+        return NULL;
+    }
+
+    options = LLVMCreatePassBuilderOptions();
+    layout = LLVMCreateTargetDataLayout(machine);
+    triple = LLVMGetTargetMachineTriple(machine);
+
+    LLVMSetTarget(module, triple);
+    LLVMSetModuleDataLayout(module, layout);
+
+    snprintf(passes, sizeof(passes), "default<O%d>",
+        program->options.optimization_level);
+
+    if (check_llvm_error(LLVMRunPasses(module, passes, machine, options)) !=
+        B_SUCCESS) {
+        LLVMDisposeModule(module);
+        module = NULL;
+    }
+
+    LLVMDisposeMessage(triple);
+    LLVMDisposeTargetData(layout);
+    LLVMDisposePassBuilderOptions(options);
+    LLVMDisposeTargetMachine(machine);
+
+    return module;
+}
+
+static inline LLVMTypeRef get_llvm_cell_type(
+    struct program const *program, LLVMContextRef context)
+{
+    return LLVMIntTypeInContext(context, program->options.cell_width);
+}
+
+/* The index is always an alloca, and the container points at cells. */
+static LLVMValueRef build_llvm_cell(LLVMBuilderRef builder,
+    LLVMValueRef container, LLVMValueRef index, long offset)
+{
+    LLVMValueRef position =
+        LLVMBuildLoad2(builder, LLVMGetAllocatedType(index), index, "");
+
+    if (offset != 0) {
+        position = LLVMBuildAdd(builder, position,
+            LLVMConstInt(LLVMTypeOf(position), offset, B_TRUE), "");
+    }
+
+    return LLVMBuildGEP2(builder, LLVMGetElementType(LLVMTypeOf(container)),
+        container, &position, 1, "");
+}
+
+/* Calls one of the functions declared by declare_llvm_runtime. */
+static LLVMValueRef build_llvm_call(LLVMModuleRef module,
+    LLVMBuilderRef builder, char const *name, LLVMValueRef *arguments,
+    unsigned int count)
+{
+    LLVMValueRef function = LLVMGetNamedFunction(module, name);
+
+    return LLVMBuildCall2(builder, LLVMGlobalGetValueType(function), function,
+        arguments, count, "");
+}
+
+/* Emits the same kernel as scan_left and scan_right: compare a vector of
+ * cells against zero, keep the lanes on the stride and jump to the nearest
+ * hit, then fall back to stepping one stride at a time near the tape ends. */
+static void build_llvm_scan(LLVMModuleRef module, LLVMBuilderRef builder,
+    LLVMValueRef container, LLVMValueRef index, size_t stride,
+    int is_reversed)
+{
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMTypeRef index_type = LLVMInt32TypeInContext(context);
+
+    LLVMValueRef main = LLVMGetBasicBlockParent(LLVMGetInsertBlock(builder));
+
+    LLVMBasicBlockRef vector_check =
+        LLVMAppendBasicBlockInContext(context, main, "vector");
+    LLVMBasicBlockRef vector_body =
+        LLVMAppendBasicBlockInContext(context, main, "compare");
+    LLVMBasicBlockRef vector_hit =
+        LLVMAppendBasicBlockInContext(context, main, "hit");
+    LLVMBasicBlockRef vector_next =
+        LLVMAppendBasicBlockInContext(context, main, "next");
+    LLVMBasicBlockRef scalar_check =
+        LLVMAppendBasicBlockInContext(context, main, "scalar");
+    LLVMBasicBlockRef scalar_next =
+        LLVMAppendBasicBlockInContext(context, main, "step");
+    LLVMBasicBlockRef done =
+        LLVMAppendBasicBlockInContext(context, main, "found");
+
+    LLVMTypeRef cell_type = LLVMGetElementType(LLVMTypeOf(container));
+    unsigned int width = LLVMGetIntTypeWidth(cell_type);
+
+    size_t lanes = B_VECTOR_WIDTH * 8 / width;
+    size_t extent = B_TAPE_EXTENT * 8 / width;
+
+    LLVMTypeRef vector = LLVMVectorType(cell_type, lanes);
+    LLVMTypeRef mask = LLVMIntTypeInContext(context, lanes);
+
+    size_t step = lanes - lanes % stride;
+    unsigned int selection = 0;
+
+    char name[32];
+    size_t i = 0;
+
+    for (; stride <= lanes && i < step; i += stride) {
+        selection |= 1U << (is_reversed ? lanes - 1 - i : i);
+    }
+
+    LLVMBuildBr(builder, stride <= lanes ? vector_check : scalar_check);
+
+    {
+        LLVMValueRef value = NULL;
+        LLVMValueRef predicate = NULL;
+
+        LLVMPositionBuilderAtEnd(builder, vector_check);
+        value = LLVMBuildLoad2(builder, index_type, index, "");
+
+        /* The index is relative to the first cell and may be negative. */
+        if (is_reversed) {
+            predicate = LLVMBuildICmp(builder, LLVMIntSGE,
+                LLVMBuildSub(builder, value,
+                    LLVMConstInt(index_type, lanes - 1, B_FALSE), ""),
+                LLVMConstInt(index_type, -(long) extent, B_TRUE), "");
+        } else {
+            predicate = LLVMBuildICmp(builder, LLVMIntSLE,
+                LLVMBuildAdd(builder, value,
+                    LLVMConstInt(index_type, lanes, B_FALSE), ""),
+                LLVMConstInt(index_type, extent, B_FALSE), "");
+        }
+
+        LLVMBuildCondBr(builder, predicate, vector_body, scalar_check);
+    }
+
+    {
+        LLVMValueRef value = NULL;
+        LLVMValueRef cells = NULL;
+        LLVMValueRef zeros = NULL;
+        LLVMValueRef found = NULL;
+        LLVMValueRef position = NULL;
+        LLVMValueRef count = NULL;
+
+        LLVMValueRef arguments[2];
+
+        LLVMPositionBuilderAtEnd(builder, vector_body);
+        value = LLVMBuildLoad2(builder, index_type, index, "");
+
+        if (is_reversed) {
+            value = LLVMBuildSub(builder, value,
+                LLVMConstInt(index_type, lanes - 1, B_FALSE), "");
+        }
+
+        cells = LLVMBuildGEP2(builder, cell_type, container, &value, 1, "");
+        cells = LLVMBuildBitCast(builder, cells,
+            LLVMPointerType(vector, B_GENERIC_ADDRESS_SPACE), "");
+
+        cells = LLVMBuildLoad2(builder, vector, cells, "");
+        LLVMSetAlignment(cells, 1);
+
+        zeros = LLVMBuildICmp(
+            builder, LLVMIntEQ, cells, LLVMConstNull(vector), "");
+        zeros = LLVMBuildBitCast(builder, zeros, mask, "");
+        zeros = LLVMBuildAnd(
+            builder, zeros, LLVMConstInt(mask, selection, B_FALSE), "");
+
+        found = LLVMBuildICmp(
+            builder, LLVMIntNE, zeros, LLVMConstNull(mask), "");
+        LLVMBuildCondBr(builder, found, vector_hit, vector_next);
+
+        LLVMPositionBuilderAtEnd(builder, vector_hit);
+
+        arguments[0] = zeros;
+        arguments[1] =
+            LLVMConstInt(LLVMInt1TypeInContext(context), B_TRUE, B_FALSE);
+
+        snprintf(name, sizeof(name), "llvm.%s.i%zd",
+            is_reversed ? "ctlz" : "cttz", lanes);
+
+        count = build_llvm_call(module, builder, name, arguments, 2);
+        count = LLVMBuildZExt(builder, count, index_type, "");
+
+        position = LLVMBuildLoad2(builder, index_type, index, "");
+
+        if (is_reversed) {
+            position = LLVMBuildSub(builder, position, count, "");
+        } else {
+            position = LLVMBuildAdd(builder, position, count, "");
+        }
+
+        LLVMBuildStore(builder, position, index);
+        LLVMBuildBr(builder, done);
+
+        LLVMPositionBuilderAtEnd(builder, vector_next);
+        position = LLVMBuildLoad2(builder, index_type, index, "");
+
+        if (is_reversed) {
+            position = LLVMBuildSub(builder, position,
+                LLVMConstInt(index_type, step, B_FALSE), "");
+        } else {
+            position = LLVMBuildAdd(builder, position,
+                LLVMConstInt(index_type, step, B_FALSE), "");
+        }
+
+        LLVMBuildStore(builder, position, index);
+        LLVMBuildBr(builder, vector_check);
+    }
+
+    {
+        LLVMValueRef value = NULL;
+        LLVMValueRef cell = NULL;
+        LLVMValueRef predicate = NULL;
+
+        LLVMPositionBuilderAtEnd(builder, scalar_check);
+        value = LLVMBuildLoad2(builder, index_type, index, "");
+        cell = LLVMBuildGEP2(builder, cell_type, container, &value, 1, "");
+
+        predicate = LLVMBuildICmp(builder, LLVMIntEQ,
+            LLVMBuildLoad2(builder, cell_type, cell, ""),
+            LLVMConstInt(cell_type, 0, B_FALSE), "");
+        LLVMBuildCondBr(builder, predicate, done, scalar_next);
+
+        LLVMPositionBuilderAtEnd(builder, scalar_next);
+
+        if (is_reversed) {
+            value = LLVMBuildSub(builder, value,
+                LLVMConstInt(index_type, stride, B_FALSE), "");
+        } else {
+            value = LLVMBuildAdd(builder, value,
+                LLVMConstInt(index_type, stride, B_FALSE), "");
+        }
+
+        LLVMBuildStore(builder, value, index);
+        LLVMBuildBr(builder, scalar_check);
+    }
+
+    LLVMPositionBuilderAtEnd(builder, done);
+}
+
+static void declare_llvm_runtime(
+    LLVMModuleRef module, struct program const *program)
+{
+    LLVMContextRef context = LLVMGetModuleContext(module);
+
+    LLVMTypeRef void_type = LLVMVoidTypeInContext(context);
+    LLVMTypeRef size_type = LLVMIntTypeInContext(context, sizeof(size_t) * 8);
+    LLVMTypeRef tape_type = LLVMPointerType(
+        LLVMInt8TypeInContext(context), B_GENERIC_ADDRESS_SPACE);
+
+    {
+        LLVMTypeRef parameters[] = {size_type};
+        LLVMTypeRef function =
+            LLVMFunctionType(tape_type, parameters, 1, B_FALSE);
+
+        LLVMAddFunction(module, "allocate_tape", function);
+    }
+
+    {
+        LLVMTypeRef parameters[] = {tape_type};
+        LLVMTypeRef function =
+            LLVMFunctionType(void_type, parameters, 1, B_FALSE);
+
+        LLVMAddFunction(module, "free_tape", function);
+    }
+
+    {
+        LLVMTypeRef parameters[] = {LLVMInt64TypeInContext(context)};
+        LLVMTypeRef function = LLVMFunctionType(
+            LLVMInt64TypeInContext(context), parameters, 1, B_FALSE);
+
+        LLVMAddFunction(module, "read_input", function);
+    }
+
+    {
+        LLVMTypeRef parameters[] = {LLVMInt32TypeInContext(context), size_type};
+        LLVMTypeRef function =
+            LLVMFunctionType(void_type, parameters, 2, B_FALSE);
+
+        LLVMAddFunction(module, "write_output", function);
+    }
+
+    {
+        LLVMTypeRef parameters[] = {tape_type, size_type};
+        LLVMTypeRef function =
+            LLVMFunctionType(void_type, parameters, 2, B_FALSE);
+
+        LLVMAddFunction(module, "write_constant", function);
+    }
+
+    {
+        LLVMTypeRef function = LLVMFunctionType(void_type, NULL, 0, B_FALSE);
+
+        LLVMAddFunction(module, "flush_output", function);
+        LLVMAddFunction(module, "exhaust_tape", function);
+    }
+
+    {
+        LLVMTypeRef mask = LLVMIntTypeInContext(
+            context, B_VECTOR_WIDTH * 8 / program->options.cell_width);
+
+        LLVMTypeRef parameters[] = {mask, LLVMInt1TypeInContext(context)};
+        LLVMTypeRef function = LLVMFunctionType(mask, parameters, 2, B_FALSE);
+
+        char name[32];
+
+        snprintf(
+            name, sizeof(name), "llvm.cttz.i%u", LLVMGetIntTypeWidth(mask));
+        LLVMAddFunction(module, name, function);
+
+        snprintf(
+            name, sizeof(name), "llvm.ctlz.i%u", LLVMGetIntTypeWidth(mask));
+        LLVMAddFunction(module, name, function);
+    }
+}
+
+/* Lowers the opcodes in [first, last) at the position of the builder, into
+ * whichever function that is. */
+static void build_llvm_opcodes(LLVMModuleRef module, LLVMBuilderRef builder,
+    LLVMValueRef container, LLVMValueRef index,
+    struct program const *program, size_t first, size_t last)
+{
+    size_t i = 0;
+    size_t k = 0;
+
+    LLVMContextRef context = LLVMGetModuleContext(module);
+
+    LLVMTypeRef index_type = LLVMInt32TypeInContext(context);
+    LLVMTypeRef size_type = LLVMIntTypeInContext(context, sizeof(size_t) * 8);
+    LLVMTypeRef cell_type = get_llvm_cell_type(program, context);
+
+    LLVMValueRef main = LLVMGetBasicBlockParent(LLVMGetInsertBlock(builder));
+
+    LLVMBasicBlockRef start = NULL;
+    LLVMBasicBlockRef end = NULL;
+
+    LLVMBasicBlockRef *stack =
+        malloc(sizeof(LLVMBasicBlockRef) * (last - first));
+
+    if (stack == NULL) {
+        abort();
+    }
+
+    for (i = first; i < last; ++i) {
+        switch (program->opcodes[i].instruction) {
+        case B_MOVE_POINTER_LEFT: {
+            LLVMValueRef value =
+                LLVMBuildLoad2(builder, index_type, index, "");
+            LLVMValueRef amount = LLVMConstInt(index_type,
+                program->opcodes[i].auxiliary, B_GENERIC_ADDRESS_SPACE);
+
+            LLVMValueRef result = LLVMBuildSub(builder, value, amount, "");
+
+            LLVMBuildStore(builder, result, index);
+            break;
+        }
+
+        case B_MOVE_POINTER_RIGHT: {
+            LLVMValueRef value =
+                LLVMBuildLoad2(builder, index_type, index, "");
+            LLVMValueRef amount = LLVMConstInt(index_type,
+                program->opcodes[i].auxiliary, B_GENERIC_ADDRESS_SPACE);
+
+            LLVMValueRef result = LLVMBuildAdd(builder, value, amount, "");
+
+            LLVMBuildStore(builder, result, index);
+            break;
+        }
+
+        case B_INCREMENT_CELL_VALUE: {
+            LLVMValueRef cell = build_llvm_cell(
+                builder, container, index, program->opcodes[i].offset);
+
+            LLVMValueRef value = LLVMBuildLoad2(builder, cell_type, cell, "");
+            LLVMValueRef increment = LLVMBuildAdd(builder, value,
+                LLVMConstInt(cell_type, program->opcodes[i].auxiliary, B_FALSE),
+                "");
+
+            LLVMBuildStore(builder, increment, cell);
+            break;
+        }
+
+        case B_DECREMENT_CELL_VALUE: {
+            LLVMValueRef cell = build_llvm_cell(
+                builder, container, index, program->opcodes[i].offset);
+
+            LLVMValueRef value = LLVMBuildLoad2(builder, cell_type, cell, "");
+            LLVMValueRef decrement = LLVMBuildSub(builder, value,
+                LLVMConstInt(cell_type, program->opcodes[i].auxiliary, B_FALSE),
+                "");
+
+            LLVMBuildStore(builder, decrement, cell);
+            break;
+        }
+
+        case B_OUTPUT_CELL_VALUE: {
+            LLVMValueRef cell = build_llvm_cell(
+                builder, container, index, program->opcodes[i].offset);
+
+            LLVMValueRef value = LLVMBuildLoad2(builder, cell_type, cell, "");
+            LLVMValueRef arguments[] = {
+                LLVMBuildIntCast2(builder, value,
+                    LLVMInt32TypeInContext(context), B_FALSE, ""),
+                LLVMConstInt(
+                    size_type, program->opcodes[i].auxiliary, B_FALSE)};
+
+            build_llvm_call(module, builder, "write_output", arguments, 2);
+            break;
+        }
+
+        case B_INPUT_CELL_VALUE: {
+            LLVMValueRef cell = build_llvm_cell(
+                builder, container, index, program->opcodes[i].offset);
+
+            LLVMValueRef value = LLVMBuildIntCast2(builder,
+                LLVMBuildLoad2(builder, cell_type, cell, ""),
+                LLVMInt64TypeInContext(context), B_FALSE, "");
+
+            LLVMValueRef input =
+                build_llvm_call(module, builder, "read_input", &value, 1);
+
+            LLVMValueRef character =
+                LLVMBuildIntCast2(builder, input, cell_type, B_FALSE, "");
+
+            LLVMBuildStore(builder, character, cell);
+            break;
+        }
+
+        case B_SET_CELL_VALUE: {
+            LLVMValueRef cell = build_llvm_cell(
+                builder, container, index, program->opcodes[i].offset);
+
+            LLVMValueRef value = LLVMConstInt(
+                cell_type, program->opcodes[i].auxiliary, B_FALSE);
+
+            LLVMBuildStore(builder, value, cell);
+            break;
+        }
+
+        case B_MULTIPLY_CELL_VALUE: {
+            LLVMValueRef source = build_llvm_cell(
+                builder, container, index, program->opcodes[i].source);
+
+            LLVMValueRef target = build_llvm_cell(
+                builder, container, index, program->opcodes[i].offset);
+
+            LLVMValueRef product = LLVMBuildMul(builder,
+                LLVMBuildLoad2(builder, cell_type, source, ""),
+                LLVMConstInt(cell_type, program->opcodes[i].auxiliary, B_FALSE),
+                "");
+
+            LLVMValueRef sum = LLVMBuildAdd(builder,
+                LLVMBuildLoad2(builder, cell_type, target, ""), product, "");
+
+            LLVMBuildStore(builder, sum, target);
+            break;
+        }
+
+        case B_SCAN_LEFT:
+        case B_SCAN_RIGHT:
+            build_llvm_scan(module, builder, container, index,
+                program->opcodes[i].auxiliary,
+                program->opcodes[i].instruction == B_SCAN_LEFT);
+            break;
+
+        case B_OUTPUT_CONSTANT: {
+            LLVMValueRef constant = LLVMConstStringInContext(context,
+                (char const *) program->constants + program->opcodes[i].offset,
+                (unsigned int) program->opcodes[i].auxiliary, B_TRUE);
+
+            LLVMValueRef global =
+                LLVMAddGlobal(module, LLVMTypeOf(constant), "constant");
+
+            LLVMValueRef arguments[] = {
+                LLVMBuildBitCast(builder, global,
+                    LLVMPointerType(LLVMInt8TypeInContext(context),
+                        B_GENERIC_ADDRESS_SPACE),
+                    ""),
+                LLVMConstInt(
+                    size_type, program->opcodes[i].auxiliary, B_FALSE)};
+
+            LLVMSetInitializer(global, constant);
+            LLVMSetGlobalConstant(global, B_TRUE);
+            LLVMSetLinkage(global, LLVMPrivateLinkage);
+
+            build_llvm_call(module, builder, "write_constant", arguments, 2);
+            break;
+        }
+
+        case B_CHECK_TAPE: {
+            LLVMTypeRef wide_type = LLVMInt64TypeInContext(context);
+            long extent =
+                (long) (B_TAPE_EXTENT / (program->options.cell_width / 8));
+
+            LLVMValueRef value = LLVMBuildSExt(builder,
+                LLVMBuildLoad2(builder, index_type, index, ""), wide_type, "");
+
+            LLVMValueRef low = LLVMBuildAdd(builder, value,
+                LLVMConstInt(wide_type, program->opcodes[i].offset, B_TRUE),
+                "");
+            LLVMValueRef high = LLVMBuildAdd(builder, value,
+                LLVMConstInt(wide_type, program->opcodes[i].source, B_TRUE),
+                "");
+
+            LLVMValueRef predicate = LLVMBuildOr(builder,
+                LLVMBuildICmp(builder, LLVMIntSLT, low,
+                    LLVMConstInt(wide_type, -extent, B_TRUE), ""),
+                LLVMBuildICmp(builder, LLVMIntSGE, high,
+                    LLVMConstInt(wide_type, extent, B_TRUE), ""),
+                "");
+
+            LLVMBasicBlockRef exhausted =
+                LLVMAppendBasicBlockInContext(context, main, "exhausted");
+            LLVMBasicBlockRef next =
+                LLVMAppendBasicBlockInContext(context, main, "next");
+
+            LLVMBuildCondBr(builder, predicate, exhausted, next);
+
+            LLVMPositionBuilderAtEnd(builder, exhausted);
+            build_llvm_call(module, builder, "exhaust_tape", NULL, 0);
+            LLVMBuildUnreachable(builder);
+
+            LLVMPositionBuilderAtEnd(builder, next);
+            break;
+        }
+
+        case B_BRANCH_FORWARD: {
+            LLVMBasicBlockRef body = NULL;
+
+            LLVMValueRef offset = NULL;
+            LLVMValueRef cell = NULL;
+            LLVMValueRef value = NULL;
+            LLVMValueRef predicate = NULL;
+
+            LLVMValueRef zero = LLVMConstInt(cell_type, 0, B_FALSE);
+
+            start = LLVMAppendBasicBlockInContext(context, main, "start");
+            stack[k++] = start;
+
+            body = LLVMAppendBasicBlockInContext(context, main, "body");
+
+            end = LLVMAppendBasicBlockInContext(context, main, "end");
+            stack[k++] = end;
+
+            LLVMBuildBr(builder, start);
+            LLVMPositionBuilderAtEnd(builder, start);
+
+            offset = LLVMBuildLoad2(builder, index_type, index, "");
+            cell = LLVMBuildGEP2(builder, cell_type, container, &offset, 1, "");
+
+            value = LLVMBuildLoad2(builder, cell_type, cell, "");
+            predicate = LLVMBuildICmp(builder, LLVMIntEQ, value, zero, "");
+
+            LLVMBuildCondBr(builder, predicate, end, body);
+
+            LLVMPositionBuilderAtEnd(builder, body);
+            break;
+        }
+
+        case B_BRANCH_BACKWARD: {
+            end = stack[--k];
+            start = stack[--k];
+
+            LLVMBuildBr(builder, start);
+            LLVMPositionBuilderAtEnd(builder, end);
+
+            break;
+        }
+
+        case B_TERMINATE:
+        default:
+            break;
+        }
+    }
+
+    free(stack);
+}
+
+static LLVMModuleRef build_llvm_module(
+    struct program const *program, LLVMContextRef context)
+{
+    if (program == NULL || program->opcodes == NULL) {
+        abort();
+    }
+
+    LLVMModuleRef module =
+        LLVMModuleCreateWithNameInContext("brainfuck", context);
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+
+    LLVMTypeRef void_type = LLVMVoidTypeInContext(context);
+    LLVMTypeRef index_type = LLVMInt32TypeInContext(context);
+    LLVMTypeRef size_type = LLVMIntTypeInContext(context, sizeof(size_t) * 8);
+    LLVMTypeRef cell_type = get_llvm_cell_type(program, context);
+
+    LLVMValueRef tape = NULL;
+    LLVMValueRef container = NULL;
+    LLVMValueRef index = NULL;
+
+    declare_llvm_runtime(module, program);
+
+    {
+        LLVMTypeRef function = LLVMFunctionType(void_type, NULL, 0, B_FALSE);
+
+        LLVMValueRef main = LLVMAddFunction(module, "main", function);
+        LLVMBasicBlockRef entry =
+            LLVMAppendBasicBlockInContext(context, main, "entry");
+
+        LLVMPositionBuilderAtEnd(builder, entry);
+    }
+
+    {
+        LLVMValueRef arguments[] = {LLVMConstInt(
+            size_type,
+            program->options.container_length *
+                program->options.cell_width / 8,
+            B_FALSE)};
+
+        LLVMValueRef zero = LLVMConstInt(index_type, 0, B_FALSE);
+
+        tape = build_llvm_call(module, builder, "allocate_tape", arguments, 1);
+        LLVMSetValueName2(tape, "tape", 4);
+        container = LLVMBuildBitCast(builder, tape,
+            LLVMPointerType(cell_type, B_GENERIC_ADDRESS_SPACE), "container");
+
+        index = LLVMBuildAlloca(builder, index_type, "index");
+        LLVMBuildStore(builder, zero, index);
+    }
+
+    build_llvm_opcodes(module, builder, container, index, program, 0,
+        program->number_of_opcodes);
+
+    build_llvm_call(module, builder, "flush_output", NULL, 0);
+    build_llvm_call(module, builder, "free_tape", &tape, 1);
+    LLVMBuildRetVoid(builder);
+
+    LLVMDisposeBuilder(builder);
+
+    return optimize_llvm_module(program, module);
+}
+
+/* A single loop for the tiered engine.  `loop_<n>` takes the tape and the
+ * index of the current cell, runs the loop opening at opcode n to completion
+ * and returns the index it stopped at. */
+static LLVMModuleRef build_llvm_loop(
+    struct program const *program, LLVMContextRef context, size_t loop)
+{
+    LLVMModuleRef module = LLVMModuleCreateWithNameInContext("loop", context);
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+
+    LLVMTypeRef index_type = LLVMInt32TypeInContext(context);
+    LLVMTypeRef container_type = LLVMPointerType(
+        get_llvm_cell_type(program, context), B_GENERIC_ADDRESS_SPACE);
+
+    LLVMValueRef function = NULL;
+    LLVMValueRef index = NULL;
+
+    char name[32];
+
+    declare_llvm_runtime(module, program);
+
+    {
+        LLVMTypeRef parameters[] = {container_type, index_type};
+        LLVMTypeRef type =
+            LLVMFunctionType(index_type, parameters, 2, B_FALSE);
+
+        snprintf(name, sizeof(name), "loop_%zu", loop);
+        function = LLVMAddFunction(module, name, type);
+
+        LLVMPositionBuilderAtEnd(builder,
+            LLVMAppendBasicBlockInContext(context, function, "entry"));
+    }
+
+    index = LLVMBuildAlloca(builder, index_type, "index");
+    LLVMBuildStore(builder, LLVMGetParam(function, 1), index);
+
+    build_llvm_opcodes(module, builder, LLVMGetParam(function, 0), index,
+        program, loop, program->opcodes[loop].auxiliary + 1);
+
+    LLVMBuildRet(builder, LLVMBuildLoad2(builder, index_type, index, ""));
+    LLVMDisposeBuilder(builder);
+
+    return optimize_llvm_module(program, module);
+}
+
+/* The runtime functions are static, so the JIT can't find them by name; they
+ * are handed to it as absolute symbols instead.  Anything else, like a
+ * `memset` the optimizer came up with, resolves against the process. */
+static enum brainfuck_status define_runtime_symbols(LLVMOrcLLJITRef jit)
+{
+    struct {
+        char const *name;
+        void *address;
+    } const symbols[] = {{"read_input", (void *) read_input},
+        {"write_output", (void *) write_output},
+        {"write_constant", (void *) write_constant},
+        {"flush_output", (void *) flush_output},
+        {"exhaust_tape", (void *) exhaust_tape},
+        {"allocate_tape", (void *) allocate_tape},
+        {"free_tape", (void *) free_tape}};
+
+    size_t const number_of_symbols = sizeof(symbols) / sizeof(*symbols);
+
+    LLVMJITCSymbolMapPair pairs[sizeof(symbols) / sizeof(*symbols)];
+    LLVMOrcDefinitionGeneratorRef generator = NULL;
+
+    LLVMOrcJITDylibRef library = LLVMOrcLLJITGetMainJITDylib(jit);
+
+    size_t i = 0;
+
+    for (; i != number_of_symbols; ++i) {
+        pairs[i].Name = LLVMOrcLLJITMangleAndIntern(jit, symbols[i].name);
+        pairs[i].Sym.Address =
+            (LLVMOrcExecutorAddress) (uintptr_t) symbols[i].address;
+        pairs[i].Sym.Flags.GenericFlags =
+            LLVMJITSymbolGenericFlagsExported |
+            LLVMJITSymbolGenericFlagsCallable;
+        pairs[i].Sym.Flags.TargetFlags = 0;
+    }
+
+    if (check_llvm_error(LLVMOrcJITDylibDefine(library,
+            LLVMOrcAbsoluteSymbols(pairs, number_of_symbols))) != B_SUCCESS ||
+        check_llvm_error(LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(
+            &generator, LLVMOrcLLJITGetGlobalPrefix(jit), NULL, NULL)) !=
+            B_SUCCESS) {
+        return B_COMPILATION_FAILED;
+    }
+
+    LLVMOrcJITDylibAddGenerator(library, generator);
+    return B_SUCCESS;
+}
+
+static enum brainfuck_status create_llvm_jit(
+    struct program const *program, LLVMOrcLLJITRef *result)
+{
+    LLVMOrcLLJITBuilderRef builder = NULL;
+    LLVMOrcLLJITRef jit = NULL;
+
+    LLVMTargetMachineRef machine = create_target_machine(
+        program, LLVMRelocDefault, LLVMCodeModelJITDefault);
+
+    if (machine == NULL) {
+        return B_COMPILATION_FAILED;
+    }
+
+    builder = LLVMOrcCreateLLJITBuilder();
+    LLVMOrcLLJITBuilderSetJITTargetMachineBuilder(builder,
+        LLVMOrcJITTargetMachineBuilderCreateFromTargetMachine(machine));
+
+    if (check_llvm_error(LLVMOrcCreateLLJIT(&jit, builder)) != B_SUCCESS) {
+        return B_COMPILATION_FAILED;
+    }
+
+    if (define_runtime_symbols(jit) != B_SUCCESS) {
+        LLVMConsumeError(LLVMOrcDisposeLLJIT(jit));
+        return B_COMPILATION_FAILED;
+    }
+
+    *result = jit;
+    return B_SUCCESS;
+}
+
+static LLVMModuleRef build_verified_module(
+    struct program const *program, LLVMContextRef context)
+{
+    LLVMModuleRef module = build_llvm_module(program, context);
+    char *error = NULL;
+
+    if (module != NULL &&
+        LLVMVerifyModule(module, LLVMReturnStatusAction, &error) != 0) {
+        LLVMDisposeModule(module);
+        module = NULL;
+    }
+
+    LLVMDisposeMessage(error);
+    return module;
+}
+
+static inline uint64_t hash_bytes(
+    uint64_t hash, void const *bytes, size_t length)
+{
+    unsigned char const *byte = bytes;
+
+    while (length-- != 0) {
+        hash = (hash ^ *byte++) * 0x100000001B3;
+    }
+
+    return hash;
+}
+
+/* The cache key covers everything that goes into the machine code: the
+ * optimized opcodes, the tape length, the cell width, the optimization level,
+ * the version and the host processor the code was tuned for.  Only the
+ * sanitized program counts, so nothing that points back at the source text
+ * goes in, and an edit to comments or whitespace still hits. */
+static uint64_t hash_program(struct program const *program)
+{
+    struct brainfuck_options const *options = &program->options;
+    uint64_t hash = 0xCBF29CE484222325;
+
+    char *processor = LLVMGetHostCPUName();
+    char *features = LLVMGetHostCPUFeatures();
+
+    size_t i = 0;
+
+    for (; i != program->number_of_opcodes; ++i) {
+        struct opcode const *opcode = program->opcodes + i;
+
+        hash = hash_bytes(
+            hash, &opcode->instruction, sizeof(opcode->instruction));
+        hash = hash_bytes(hash, &opcode->auxiliary, sizeof(opcode->auxiliary));
+        hash = hash_bytes(hash, &opcode->offset, sizeof(opcode->offset));
+
+        /* The second cell of a multiplication or a tape check. */
+        if (opcode->instruction == B_MULTIPLY_CELL_VALUE ||
+            opcode->instruction == B_CHECK_TAPE) {
+            hash = hash_bytes(hash, &opcode->source, sizeof(opcode->source));
+        }
+    }
+
+    if (program->constants != NULL) {
+        hash = hash_bytes(hash, program->constants, program->constants_length);
+    }
+
+    hash = hash_bytes(
+        hash, &options->container_length, sizeof(options->container_length));
+    hash = hash_bytes(hash, &options->cell_width, sizeof(options->cell_width));
+    hash = hash_bytes(hash, &options->optimization_level,
+        sizeof(options->optimization_level));
+
+    hash = hash_bytes(hash, B_VERSION_STRING, sizeof(B_VERSION_STRING));
+    hash = hash_bytes(hash, processor, strlen(processor) + 1);
+    hash = hash_bytes(hash, features, strlen(features) + 1);
+
+    LLVMDisposeMessage(processor);
+    LLVMDisposeMessage(features);
+
+    return hash;
+}
+
+struct cache_entry {
+    char name[32];
+    size_t length;
+    time_t time;
+};
+
+static int compare_cache_entries(void const *left, void const *right)
+{
+    time_t a = ((struct cache_entry const *) left)->time;
+    time_t b = ((struct cache_entry const *) right)->time;
+
+    return (a > b) - (a < b);
+}
+
+/* Objects are touched whenever they are used, so evicting the oldest first
+ * drops whatever was used least recently.  Eviction is best effort. */
+static void evict_cached_objects(char const *cache)
+{
+    struct cache_entry *entries = NULL;
+    size_t number_of_entries = 0;
+    size_t capacity = 0;
+    size_t total = 0;
+
+    struct dirent *entry = NULL;
+    DIR *directory = opendir(cache);
+
+    size_t i = 0;
+
+    if (directory == NULL) {
+        return;
+    }
+
+    while ((entry = readdir(directory)) != NULL) {
+        size_t length = strlen(entry->d_name);
+
+        char path[4096];
+        struct stat status;
+
+        if (length < 3 || length >= sizeof(entries->name) ||
+            strcmp(entry->d_name + length - 2, ".o") != 0) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s", cache, entry->d_name);
+
+        if (stat(path, &status) != 0) {
+            continue;
+        }
+
+        if (number_of_entries == capacity) {
+            struct cache_entry *resized = NULL;
+
+            capacity = capacity == 0 ? 64 : capacity * 2;
+            resized = realloc(entries, capacity * sizeof(*entries));
+
+            if (resized == NULL) {
+                break;
+            }
+
+            entries = resized;
+        }
+
+        strcpy(entries[number_of_entries].name, entry->d_name);
+        entries[number_of_entries].length = status.st_size;
+        entries[number_of_entries].time = status.st_mtime;
+
+        total += entries[number_of_entries++].length;
+    }
+
+    closedir(directory);
+
+    qsort(entries, number_of_entries, sizeof(*entries), compare_cache_entries);
+
+    for (; i != number_of_entries && total > B_CACHE_LIMIT; ++i) {
+        char path[4096];
+
+        snprintf(path, sizeof(path), "%s/%s", cache, entries[i].name);
+
+        if (unlink(path) == 0) {
+            total -= entries[i].length;
+        }
+    }
+
+    free(entries);
+}
+
+/* The hit and miss counters live next to the objects, so they add up over
+ * every run that shares the directory.  Like eviction, counting is best
+ * effort. */
+static void count_cache_access(char const *cache, int is_hit,
+    struct brainfuck_statistics *statistics)
+{
+    unsigned long long hits = 0;
+    unsigned long long misses = 0;
+
+    char path[4096];
+    FILE *file = NULL;
+
+    int descriptor = -1;
+
+    statistics->is_cached = is_hit;
+
+    snprintf(path, sizeof(path), "%s/statistics", cache);
+    descriptor = open(path, O_RDWR | O_CREAT, 0666);
+
+    if (descriptor == -1 || (file = fdopen(descriptor, "r+")) == NULL) {
+        if (descriptor != -1) {
+            close(descriptor);
+        }
+
+        return;
+    }
+
+    flock(descriptor, LOCK_EX);
+
+    if (fscanf(file, "%llu %llu", &hits, &misses) != 2) {
+        hits = 0;
+        misses = 0;
+    }
+
+    hits += is_hit == B_TRUE;
+    misses += is_hit == B_FALSE;
+
+    rewind(file);
+    fprintf(file, "%llu %llu\n", hits, misses);
+    fflush(file);
+
+    flock(descriptor, LOCK_UN);
+    fclose(file);
+
+    statistics->cache_hits = hits;
+    statistics->cache_misses = misses;
+}
+
+static void get_cached_object_path(
+    struct program const *program, char *path, size_t length)
+{
+    snprintf(path, length, "%s/%016" PRIx64 ".o",
+        program->options.cache_directory, hash_program(program));
+}
+
+/* Written next to its final name and renamed into place, so concurrent runs
+ * never see half an object.  A cache that cannot be written to is simply
+ * not used. */
+static int store_cached_object(char const *path, LLVMMemoryBufferRef object)
+{
+    char temporary[4096 + 8];
+    size_t length = LLVMGetBufferSize(object);
+
+    int descriptor = -1;
+
+    snprintf(temporary, sizeof(temporary), "%s.XXXXXX", path);
+
+    if ((descriptor = mkstemp(temporary)) == -1) {
+        return B_FALSE;
+    }
+
+    if (write(descriptor, LLVMGetBufferStart(object), length) !=
+            (ssize_t) length ||
+        close(descriptor) != 0 || rename(temporary, path) != 0) {
+        unlink(temporary);
+        return B_FALSE;
+    }
+
+    return B_TRUE;
+}
+
+/* Looks the program up in the cache directory, and on a miss compiles it
+ * to an object with the JIT's own settings and stores that, so a warm start
+ * skips LLVM up to linking.  A hit is only marked here, since it does not
+ * count until the object has linked. */
+static enum brainfuck_status load_cached_object(struct program const *program,
+    struct brainfuck_statistics *statistics, LLVMMemoryBufferRef *result)
+{
+    LLVMContextRef context = NULL;
+    LLVMModuleRef module = NULL;
+    LLVMTargetMachineRef machine = NULL;
+    LLVMMemoryBufferRef object = NULL;
+
+    char const *cache = program->options.cache_directory;
+
+    char path[4096];
+    char *error = NULL;
+
+    mkdir(cache, 0777);
+    get_cached_object_path(program, path, sizeof(path));
+
+    if (LLVMCreateMemoryBufferWithContentsOfFile(path, &object, &error) == 0) {
+        utimes(path, NULL);
+        statistics->is_cached = B_TRUE;
+
+        *result = object;
+        return B_SUCCESS;
+    }
+
+    LLVMDisposeMessage(error);
+    error = NULL;
+
+    /* Whatever is there but cannot be read is in the way. */
+    unlink(path);
+
+    context = LLVMContextCreate();
+    module = build_verified_module(program, context);
+    machine = create_target_machine(
+        program, LLVMRelocDefault, LLVMCodeModelJITDefault);
+
+    if (module == NULL || machine == NULL ||
+        LLVMTargetMachineEmitToMemoryBuffer(
+            machine, module, LLVMObjectFile, &error, &object) != 0) {
+        object = NULL;
+    }
+
+    LLVMDisposeMessage(error);
+
+    if (machine != NULL) {
+        LLVMDisposeTargetMachine(machine);
+    }
+
+    if (module != NULL) {
+        LLVMDisposeModule(module);
+    }
+
+    LLVMContextDispose(context);
+
+    if (object == NULL) {
+        return B_COMPILATION_FAILED;
+    }
+
+    count_cache_access(cache, B_FALSE, statistics);
+
+    if (store_cached_object(path, object) == B_TRUE) {
+        evict_cached_objects(cache);
+    }
+
+    *result = object;
+    return B_SUCCESS;
+}
+
+static enum brainfuck_status link_program(struct program const *program,
+    struct brainfuck_statistics *statistics, LLVMOrcLLJITRef *result,
+    LLVMOrcExecutorAddress *address)
+{
+    LLVMOrcLLJITRef jit = NULL;
+    LLVMOrcJITDylibRef library = NULL;
+
+    enum brainfuck_status status = create_llvm_jit(program, &jit);
+
+    if (status != B_SUCCESS) {
+        return status;
+    }
+
+    library = LLVMOrcLLJITGetMainJITDylib(jit);
+
+    if (program->options.cache_directory != NULL) {
+        LLVMMemoryBufferRef object = NULL;
+
+        status = load_cached_object(program, statistics, &object);
+
+        if (status == B_SUCCESS) {
+            status = check_llvm_error(
+                LLVMOrcLLJITAddObjectFile(jit, library, object));
+        }
+    } else {
+        LLVMOrcThreadSafeContextRef context =
+            LLVMOrcCreateNewThreadSafeContext();
+
+        LLVMModuleRef module = build_verified_module(
+            program, LLVMOrcThreadSafeContextGetContext(context));
+
+        if (module == NULL) {
+            status = B_COMPILATION_FAILED;
+        } else {
+            status = check_llvm_error(LLVMOrcLLJITAddLLVMIRModule(jit,
+                library, LLVMOrcCreateNewThreadSafeModule(module, context)));
+        }
+
+        LLVMOrcDisposeThreadSafeContext(context);
+    }
+
+    if (status == B_SUCCESS) {
+        status = check_llvm_error(LLVMOrcLLJITLookup(jit, address, "main"));
+    }
+
+    if (status != B_SUCCESS) {
+        LLVMConsumeError(LLVMOrcDisposeLLJIT(jit));
+        return status;
+    }
+
+    if (statistics->is_cached == B_TRUE) {
+        count_cache_access(
+            program->options.cache_directory, B_TRUE, statistics);
+    }
+
+    *result = jit;
+    return B_SUCCESS;
+}
+
+/* Compiles the whole program into a JIT of its own and looks up its entry
+ * point, which stays valid for as long as the JIT does.  A cached object
+ * that does not link is thrown away and the program compiled afresh. */
+static enum brainfuck_status compile_program(struct program const *program,
+    struct brainfuck_statistics *statistics, LLVMOrcLLJITRef *result,
+    void (**main)(void))
+{
+    LLVMOrcLLJITRef jit = NULL;
+    LLVMOrcExecutorAddress address = 0;
+
+    double start = get_time();
+
+    enum brainfuck_status status =
+        link_program(program, statistics, &jit, &address);
+
+    if (status != B_SUCCESS && statistics->is_cached == B_TRUE) {
+        char path[4096];
+
+        get_cached_object_path(program, path, sizeof(path));
+        unlink(path);
+
+        statistics->is_cached = B_FALSE;
+        status = link_program(program, statistics, &jit, &address);
+    }
+
+    if (status != B_SUCCESS) {
+        return status;
+    }
+
+    statistics->compilation_time = get_time() - start;
+
+    *result = jit;
+    *main = (void (*)(void)) (uintptr_t) address;
+
+    return B_SUCCESS;
+}
+
+/* The compiler thread of the tiered engine.  It owns a JIT of its own and
+ * works through the queue one loop at a time until it is told to stop.  A
+ * loop that fails to compile just stays with the interpreter. */
+static void compile_hot_loop(struct tier *tier, LLVMOrcLLJITRef jit,
+    size_t loop)
+{
+    LLVMOrcThreadSafeContextRef context = LLVMOrcCreateNewThreadSafeContext();
+    LLVMOrcExecutorAddress address = 0;
+    LLVMModuleRef module = NULL;
+
+    char name[32];
+    double start = get_time();
+
+    module = build_llvm_loop(
+        tier->program, LLVMOrcThreadSafeContextGetContext(context), loop);
+
+    if (module == NULL ||
+        check_llvm_error(LLVMOrcLLJITAddLLVMIRModule(jit,
+            LLVMOrcLLJITGetMainJITDylib(jit),
+            LLVMOrcCreateNewThreadSafeModule(module, context))) !=
+            B_SUCCESS) {
+        LLVMOrcDisposeThreadSafeContext(context);
+        return;
+    }
+
+    LLVMOrcDisposeThreadSafeContext(context);
+
+    snprintf(name, sizeof(name), "loop_%zu", loop);
+
+    if (check_llvm_error(LLVMOrcLLJITLookup(jit, &address, name)) !=
+        B_SUCCESS) {
+        return;
+    }
+
+    atomic_store_explicit(&tier->loops[loop],
+        (compiled_loop) (uintptr_t) address, memory_order_release);
+
+    ++tier->number_of_compiled_loops;
+    tier->compilation_time += get_time() - start;
+}
+
+static void *compile_hot_loops(void *argument)
+{
+    struct tier *tier = argument;
+    LLVMOrcLLJITRef jit = NULL;
+
+    int is_disabled = create_llvm_jit(tier->program, &jit) != B_SUCCESS;
+
+    pthread_mutex_lock(&tier->mutex);
+
+    for (;;) {
+        size_t loop = 0;
+
+        while (tier->head == tier->tail && tier->is_stopping == B_FALSE) {
+            pthread_cond_wait(&tier->condition, &tier->mutex);
+        }
+
+        if (tier->is_stopping == B_TRUE) {
+            break;
+        }
+
+        loop = tier->queue[tier->head++];
+        pthread_mutex_unlock(&tier->mutex);
+
+        if (is_disabled == B_FALSE) {
+            compile_hot_loop(tier, jit, loop);
+        }
+
+        pthread_mutex_lock(&tier->mutex);
+    }
+
+    pthread_mutex_unlock(&tier->mutex);
+
+    if (jit != NULL) {
+        LLVMConsumeError(LLVMOrcDisposeLLJIT(jit));
+    }
+
+    return NULL;
+}
+
+static void free_tier(struct tier *tier)
+{
+    if (tier != NULL) {
+        free(tier->queue);
+        free(tier->loops);
+        free(tier->counters);
+    }
+
+    free(tier);
+}
+
+static enum brainfuck_status start_tier(
+    struct program const *program, struct tier **result)
+{
+    struct tier *tier = calloc(1, sizeof(struct tier));
+    size_t i = 0;
+
+    if (tier == NULL) {
+        return B_OUT_OF_MEMORY;
+    }
+
+    tier->program = program;
+
+    tier->counters = calloc(program->number_of_opcodes, sizeof(size_t));
+    tier->loops = malloc(program->number_of_opcodes * sizeof(*tier->loops));
+    tier->queue = malloc(program->number_of_opcodes * sizeof(size_t));
+
+    if (tier->counters == NULL || tier->loops == NULL || tier->queue == NULL) {
+        free_tier(tier);
+        return B_OUT_OF_MEMORY;
+    }
+
+    for (; i != program->number_of_opcodes; ++i) {
+        atomic_init(&tier->loops[i], NULL);
+    }
+
+    pthread_mutex_init(&tier->mutex, NULL);
+    pthread_cond_init(&tier->condition, NULL);
+
+    if (pthread_create(&tier->thread, NULL, compile_hot_loops, tier) != 0) {
+        pthread_cond_destroy(&tier->condition);
+        pthread_mutex_destroy(&tier->mutex);
+
+        free_tier(tier);
+        return B_OUT_OF_MEMORY;
+    }
+
+    *result = tier;
+    return B_SUCCESS;
+}
+
+/* Loops that are still waiting are dropped, but one that is being compiled
+ * is finished first. */
+static void stop_tier(
+    struct tier *tier, struct brainfuck_run_statistics *statistics)
+{
+    pthread_mutex_lock(&tier->mutex);
+
+    tier->is_stopping = B_TRUE;
+    pthread_cond_signal(&tier->condition);
+
+    pthread_mutex_unlock(&tier->mutex);
+    pthread_join(tier->thread, NULL);
+
+    statistics->number_of_hot_loops = tier->tail;
+    statistics->number_of_compiled_loops = tier->number_of_compiled_loops;
+    statistics->compilation_time = tier->compilation_time;
+
+    pthread_cond_destroy(&tier->condition);
+    pthread_mutex_destroy(&tier->mutex);
+
+    free_tier(tier);
+}
+
+/* The template JIT: x86-64 machine code for each opcode, written straight
+ * into an anonymous mapping that is made executable once it is complete.
+ * The cell pointer lives in rbx for the whole program and everything else
+ * goes through the runtime functions, called by absolute address. */
+typedef void (*assembled_program)(void *tape);
+
+#if defined(__x86_64__)
+#define B_MAXIMUM_TEMPLATE_LENGTH 32
+
+struct assembler {
+    unsigned char *code;
+    size_t length;
+
+    int width;
+    enum brainfuck_status status;
+};
+
+static inline void emit_byte(struct assembler *assembler, unsigned int byte)
+{
+    assembler->code[assembler->length++] = (unsigned char) byte;
+}
+
+static inline void emit_word(struct assembler *assembler, uint32_t word)
+{
+    memcpy(assembler->code + assembler->length, &word, sizeof(word));
+    assembler->length += sizeof(word);
+}
+
+static inline void emit_quad(struct assembler *assembler, uint64_t quad)
+{
+    memcpy(assembler->code + assembler->length, &quad, sizeof(quad));
+    assembler->length += sizeof(quad);
+}
+
+/* A ModRM byte for [rbx + disp32], followed by the displacement. */
+static void emit_cell_operand(
+    struct assembler *assembler, unsigned int reg, long offset)
+{
+    long displacement = offset * (assembler->width / 8);
+
+    if (displacement < INT32_MIN || displacement > INT32_MAX) {
+        assembler->status = B_UNSUPPORTED;
+        displacement = 0;
+    }
+
+    emit_byte(assembler, 0x80 | reg << 3 | 3);
+    emit_word(assembler, (uint32_t) displacement);
+}
+
+/* The operand size prefix of an instruction on a whole cell.  Byte cells use
+ * their own opcode instead, one below the one given here. */
+static void emit_cell_opcode(struct assembler *assembler, unsigned int opcode)
+{
+    switch (assembler->width) {
+    case 8:
+        emit_byte(assembler, opcode - 1);
+        return;
+
+    case 16:
+        emit_byte(assembler, 0x66);
+        break;
+
+    case 64:
+        emit_byte(assembler, 0x48);
+        break;
+    }
+
+    emit_byte(assembler, opcode);
+}
+
+static void emit_call(struct assembler *assembler, void *function)
+{
+    emit_byte(assembler, 0x48); /* mov rax, imm64 */
+    emit_byte(assembler, 0xB8);
+    emit_quad(assembler, (uint64_t) (uintptr_t) function);
+
+    emit_byte(assembler, 0xFF); /* call rax */
+    emit_byte(assembler, 0xD0);
+}
+
+/* Loads a cell, zero extended, into eax (reg 0) or edi (reg 7). */
+static void emit_load_cell(
+    struct assembler *assembler, unsigned int reg, long offset)
+{
+    if (assembler->width <= 16) {
+        emit_byte(assembler, 0x0F); /* movzx */
+        emit_byte(assembler, assembler->width == 8 ? 0xB6 : 0xB7);
+    } else {
+        if (assembler->width == 64) {
+            emit_byte(assembler, 0x48);
+        }
+
+        emit_byte(assembler, 0x8B); /* mov */
+    }
+
+    emit_cell_operand(assembler, reg, offset);
+}
+
+/* `add`, `sub` or `mov` of a constant into a cell.  The constant is cut to
+ * the cell width, except that a 64-bit one outside the sign extended 32-bit
+ * range goes through rax. */
+static void emit_cell_immediate(struct assembler *assembler,
+    unsigned int opcode, unsigned int extension, unsigned int register_opcode,
+    long offset, uint64_t value)
+{
+    if (assembler->width == 64 && (int64_t) value != (int32_t) value) {
+        emit_byte(assembler, 0x48); /* mov rax, imm64 */
+        emit_byte(assembler, 0xB8);
+        emit_quad(assembler, value);
+
+        emit_cell_opcode(assembler, register_opcode);
+        emit_cell_operand(assembler, 0, offset);
+
+        return;
+    }
+
+    emit_cell_opcode(assembler, opcode);
+    emit_cell_operand(assembler, extension, offset);
+
+    switch (assembler->width) {
+    case 8:
+        emit_byte(assembler, value);
+        break;
+
+    case 16:
+        emit_byte(assembler, value);
+        emit_byte(assembler, value >> 8);
+        break;
+
+    default:
+        emit_word(assembler, (uint32_t) value);
+    }
+}
+
+static void emit_opcode_template(struct assembler *assembler,
+    struct program const *program, size_t i, size_t *patches)
+{
+    static void *const scans[][2] = {
+        {(void *) scan_left_8, (void *) scan_right_8},
+        {(void *) scan_left_16, (void *) scan_right_16},
+        {(void *) scan_left_32, (void *) scan_right_32},
+        {(void *) scan_left_64, (void *) scan_right_64}};
+
+    struct opcode const *opcode = program->opcodes + i;
+    size_t width = get_interpreter(program) - B_INTERPRETERS;
+
+    switch (opcode->instruction) {
+    case B_MOVE_POINTER_LEFT:
+    case B_MOVE_POINTER_RIGHT:
+        emit_byte(assembler, 0x48); /* add/sub rbx, imm32 */
+        emit_byte(assembler, 0x81);
+        emit_byte(assembler,
+            opcode->instruction == B_MOVE_POINTER_LEFT ? 0xEB : 0xC3);
+        emit_word(
+            assembler, (uint32_t) (opcode->auxiliary * (assembler->width / 8)));
+        break;
+
+    case B_INCREMENT_CELL_VALUE:
+        emit_cell_immediate(
+            assembler, 0x81, 0, 0x01, opcode->offset, opcode->auxiliary);
+        break;
+
+    case B_DECREMENT_CELL_VALUE:
+        emit_cell_immediate(
+            assembler, 0x81, 5, 0x29, opcode->offset, opcode->auxiliary);
+        break;
+
+    case B_SET_CELL_VALUE:
+        emit_cell_immediate(
+            assembler, 0xC7, 0, 0x89, opcode->offset, opcode->auxiliary);
+        break;
+
+    case B_MULTIPLY_CELL_VALUE:
+        emit_load_cell(assembler, 0, opcode->source);
+
+        if (opcode->auxiliary != 1) {
+            if ((int64_t) opcode->auxiliary == (int32_t) opcode->auxiliary ||
+                assembler->width != 64) {
+                if (assembler->width == 64) {
+                    emit_byte(assembler, 0x48);
+                }
+
+                emit_byte(assembler, 0x69); /* imul eax, eax, imm32 */
+                emit_byte(assembler, 0xC0);
+                emit_word(assembler, (uint32_t) opcode->auxiliary);
+            } else {
+                emit_byte(assembler, 0x48); /* mov rcx, imm64 */
+                emit_byte(assembler, 0xB9);
+                emit_quad(assembler, opcode->auxiliary);
+
+                emit_byte(assembler, 0x48); /* imul rax, rcx */
+                emit_byte(assembler, 0x0F);
+                emit_byte(assembler, 0xAF);
+                emit_byte(assembler, 0xC1);
+            }
+        }
+
+        emit_cell_opcode(assembler, 0x01); /* add [cell], eax */
+        emit_cell_operand(assembler, 0, opcode->offset);
+        break;
+
+    case B_OUTPUT_CELL_VALUE:
+        emit_byte(assembler, 0x0F); /* movzx edi, byte [cell] */
+        emit_byte(assembler, 0xB6);
+        emit_cell_operand(assembler, 7, opcode->offset);
+
+        emit_byte(assembler, 0x48); /* mov rsi, imm64 */
+        emit_byte(assembler, 0xBE);
+        emit_quad(assembler, opcode->auxiliary);
+
+        emit_call(assembler, (void *) write_output);
+        break;
+
+    case B_INPUT_CELL_VALUE:
+        emit_load_cell(assembler, 7, opcode->offset);
+        emit_call(assembler, (void *) read_input);
+
+        emit_cell_opcode(assembler, 0x89); /* mov [cell], eax */
+        emit_cell_operand(assembler, 0, opcode->offset);
+        break;
+
+    case B_SCAN_LEFT:
+    case B_SCAN_RIGHT:
+        emit_byte(assembler, 0x48); /* mov rdi, rbx */
+        emit_byte(assembler, 0x89);
+        emit_byte(assembler, 0xDF);
+
+        emit_byte(assembler, 0x48); /* mov rsi, imm64 */
+        emit_byte(assembler, 0xBE);
+        emit_quad(assembler, opcode->auxiliary);
+
+        emit_call(assembler,
+            scans[width][opcode->instruction == B_SCAN_RIGHT]);
+
+        emit_byte(assembler, 0x48); /* mov rbx, rax */
+        emit_byte(assembler, 0x89);
+        emit_byte(assembler, 0xC3);
+        break;
+
+    case B_OUTPUT_CONSTANT:
+        emit_byte(assembler, 0x48); /* mov rdi, imm64 */
+        emit_byte(assembler, 0xBF);
+        emit_quad(assembler,
+            (uint64_t) (uintptr_t) (program->constants + opcode->offset));
+
+        emit_byte(assembler, 0x48); /* mov rsi, imm64 */
+        emit_byte(assembler, 0xBE);
+        emit_quad(assembler, opcode->auxiliary);
+
+        emit_call(assembler, (void *) write_constant);
+        break;
+
+    case B_CHECK_TAPE:
+        emit_byte(assembler, 0x48); /* lea rdi, [cell] */
+        emit_byte(assembler, 0x8D);
+        emit_cell_operand(assembler, 7, opcode->offset);
+
+        emit_byte(assembler, 0x48); /* lea rsi, [cell] */
+        emit_byte(assembler, 0x8D);
+        emit_cell_operand(assembler, 6, opcode->source);
+
+        emit_call(assembler, (void *) check_tape);
+        break;
+
+    case B_BRANCH_FORWARD:
+    case B_BRANCH_BACKWARD:
+        emit_cell_immediate(assembler, 0x81, 7, 0x39, 0, 0); /* cmp */
+
+        emit_byte(assembler, 0x0F); /* je/jne rel32 */
+        emit_byte(assembler,
+            opcode->instruction == B_BRANCH_FORWARD ? 0x84 : 0x85);
+        emit_word(assembler, 0);
+
+        /* The jump lands right after its partner, whose own jump is
+         * patched to come back here once both are known. */
+        patches[i] = assembler->length;
+
+        if (opcode->instruction == B_BRANCH_BACKWARD) {
+            size_t target = patches[opcode->auxiliary];
+
+            uint32_t forward = (uint32_t) (assembler->length - target);
+            uint32_t backward = (uint32_t) (target - assembler->length);
+
+            memcpy(assembler->code + target - 4, &forward, sizeof(forward));
+            memcpy(assembler->code + assembler->length - 4, &backward,
+                sizeof(backward));
+        }
+
+        break;
+
+    case B_TERMINATE:
+    default:
+        break;
+    }
+}
+
+static enum brainfuck_status assemble(struct program const *program,
+    assembled_program *function, size_t *length)
+{
+    struct assembler assembler = {NULL, 0, 0, B_SUCCESS};
+
+    size_t *patches = malloc(sizeof(size_t) * program->number_of_opcodes);
+    size_t capacity = (program->number_of_opcodes + 1) *
+        B_MAXIMUM_TEMPLATE_LENGTH;
+
+    size_t i = 0;
+
+    if (patches == NULL) {
+        return B_OUT_OF_MEMORY;
+    }
+
+    assembler.width = program->options.cell_width;
+    assembler.code = mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (assembler.code == MAP_FAILED) {
+        free(patches);
+        return B_OUT_OF_MEMORY;
+    }
+
+    emit_byte(&assembler, 0x53); /* push rbx */
+    emit_byte(&assembler, 0x48); /* mov rbx, rdi */
+    emit_byte(&assembler, 0x89);
+    emit_byte(&assembler, 0xFB);
+
+    for (; i != program->number_of_opcodes; ++i) {
+        emit_opcode_template(&assembler, program, i, patches);
+    }
+
+    emit_byte(&assembler, 0x5B); /* pop rbx */
+    emit_byte(&assembler, 0xC3); /* ret */
+
+    free(patches);
+
+    if (assembler.status == B_SUCCESS &&
+        mprotect(assembler.code, capacity, PROT_READ | PROT_EXEC) != 0) {
+        assembler.status = B_OUT_OF_MEMORY;
+    }
+
+    if (assembler.status != B_SUCCESS) {
+        munmap(assembler.code, capacity);
+        return assembler.status;
+    }
+
+    *function = (assembled_program) assembler.code;
+    *length = capacity;
+
+    return B_SUCCESS;
+}
+#else
+static enum brainfuck_status assemble(struct program const *program,
+    assembled_program *function, size_t *length)
+{
+    (void) program;
+    (void) function;
+    (void) length;
+
+    return B_UNSUPPORTED;
+}
+#endif
+
+static void disassamble(struct bytecode const *bytecode, FILE *file)
+{
+    size_t i = 0;
+
+    if (bytecode == NULL || bytecode->words == NULL) {
+        abort();
+    }
+
+    fprintf(file, ",- b ------------------------------------------.\n");
+
+    for (; i != bytecode->number_of_words; ++i) {
+        struct opcode opcode;
+
+        if ((bytecode->words[i] & 0xFF) == B_TERMINATE) {
+            break;
+        }
+
+        decode_opcode(bytecode, i, &opcode);
+
+        fprintf(file,
+            "| 0x%08zX | %08" PRIX32 " | %05zd:%02d | %+05ld | %c |\n", i,
+            bytecode->words[i], opcode.auxiliary, opcode.instruction,
+            opcode.offset, opcode.instruction);
+    }
+
+    fprintf(file, "\\-------~ ............................ ~-------/\n");
+}
+
+static void explain_opcode(FILE *file, struct opcode const *opcode)
+{
+    if (opcode == NULL) {
+        abort();
+    }
+
+    switch (opcode->instruction) {
+    case B_MOVE_POINTER_LEFT:
+        fprintf(file, "| move-pointer-left       |   (%05zd)   |",
+            opcode->auxiliary);
+        break;
+
+    case B_MOVE_POINTER_RIGHT:
+        fprintf(file, "| move-pointer-right      |   (%05zd)   |",
+            opcode->auxiliary);
+        break;
+
+    case B_INCREMENT_CELL_VALUE:
+        fprintf(file, "| increment-cell-value    |   (%05zd)   |",
+            opcode->auxiliary);
+        break;
+
+    case B_DECREMENT_CELL_VALUE:
+        fprintf(file, "| decrement-cell-value    |   (%05zd)   |",
+            opcode->auxiliary);
+        break;
+
+    case B_OUTPUT_CELL_VALUE:
+        fprintf(file, "| output-cell-value       |   (%05zd)   |",
+            opcode->auxiliary);
+        break;
+
+    case B_INPUT_CELL_VALUE:
+        fprintf(file, "| input-cell-value        |      ~      |");
+        break;
+
+    case B_BRANCH_FORWARD:
+        fprintf(file, "| branch-if-zero          | [x%08zX] |",
+            opcode->auxiliary);
+        break;
+
+    case B_BRANCH_BACKWARD:
+        fprintf(file, "| branch-back-if-not-zero | [x%08zX] |",
+            opcode->auxiliary);
+        break;
+
+    case B_SET_CELL_VALUE:
+        fprintf(file, "| set-cell-value          |   [%05zd]   |",
+            opcode->auxiliary);
+        break;
+
+    case B_MULTIPLY_CELL_VALUE:
+        fprintf(file, "| multiply-add-cell-value | (%+05ld)*%03zd |",
+            opcode->offset, opcode->auxiliary);
+        break;
+
+    case B_SCAN_LEFT:
+        fprintf(file, "| scan-left-for-zero      |   (%05zd)   |",
+            opcode->auxiliary);
+        break;
+
+    case B_SCAN_RIGHT:
+        fprintf(file, "| scan-right-for-zero     |   (%05zd)   |",
+            opcode->auxiliary);
+        break;
+
+    case B_OUTPUT_CONSTANT:
+        fprintf(file, "| output-constant         |   (%05zd)   |",
+            opcode->auxiliary);
+        break;
+
+    case B_CHECK_TAPE:
+        fprintf(file, "| check-tape-range        |(%+05ld:%+05ld)|",
+            opcode->offset, opcode->source);
+        break;
+
+    case B_TERMINATE:
+        fprintf(file, "| terminate-execution ----------------------------/");
+
+    default:
+        break;
+    }
+}
+
+static void explain(struct bytecode const *bytecode, FILE *file)
+{
+    size_t i = 0;
+
+    if (bytecode == NULL || bytecode->words == NULL) {
+        abort();
+    }
+
+    fprintf(file, ",- b ---------------------------------------------.\n");
+    fprintf(file, "| (): relative | []: absolute | ~: n/a  | @: cell |\n");
+    fprintf(file, "|-------------------------------------------------|\n");
+
+    for (; i != bytecode->number_of_words; ++i) {
+        struct opcode opcode;
+
+        decode_opcode(bytecode, i, &opcode);
+        explain_opcode(file, &opcode);
+
+        if (is_cell_instruction(opcode.instruction)) {
+            fprintf(file, " (%+05ld) |",
+                opcode.instruction == B_MULTIPLY_CELL_VALUE ? opcode.source
+                                                            : opcode.offset);
+        } else if (opcode.instruction != B_TERMINATE) {
+            fprintf(file, "    ~    |");
+        }
+
+        fputc('\n', file);
+    }
+}
+
+struct ranking {
+    uint64_t key;
+    size_t index;
+};
+
+static int compare_rankings(void const *left, void const *right)
+{
+    uint64_t a = ((struct ranking const *) left)->key;
+    uint64_t b = ((struct ranking const *) right)->key;
+
+    return (a < b) - (a > b);
+}
+
+/* The hottest loops by the ticks spent in them, then the hottest opcodes by
+ * how often they ran, in the layout of the `explain` table, then the pairs of
+ * instructions that most often ran one straight after the other, with the
+ * superinstruction that runs each, if any.  `@` is where in the source a
+ * loop or an opcode starts. */
+static enum brainfuck_status report_profile(struct program const *program,
+    struct profile const *profile, FILE *report)
+{
+    struct ranking *loops =
+        malloc(sizeof(struct ranking) * program->number_of_opcodes);
+    struct ranking *opcodes =
+        malloc(sizeof(struct ranking) * program->number_of_opcodes);
+    struct ranking *pairs = calloc(256 * 256, sizeof(struct ranking));
+
+    size_t number_of_loops = 0;
+    uint64_t executed = 0;
+
+    size_t i = 0;
+
+    if (loops == NULL || opcodes == NULL || pairs == NULL) {
+        free(pairs);
+        free(opcodes);
+        free(loops);
+
+        return B_OUT_OF_MEMORY;
+    }
+
+    for (; i != 256 * 256; ++i) {
+        pairs[i].index = i;
+    }
+
+    for (i = 0; i + 1 < program->number_of_opcodes; ++i) {
+        pairs[(program->opcodes[i].instruction & 0xFF) << 8 |
+            (program->opcodes[i + 1].instruction & 0xFF)]
+            .key += profile->successions[i];
+    }
+
+    for (i = 0; i != program->number_of_opcodes; ++i) {
+        opcodes[i].key = profile->executions[i];
+        opcodes[i].index = i;
+
+        executed += profile->executions[i];
+
+        if (program->opcodes[i].instruction == B_BRANCH_FORWARD &&
+            profile->iterations[i] != 0) {
+            loops[number_of_loops].key = profile->ticks[i];
+            loops[number_of_loops++].index = i;
+        }
+    }
+
+    qsort(loops, number_of_loops, sizeof(struct ranking), compare_rankings);
+    qsort(opcodes, program->number_of_opcodes, sizeof(struct ranking),
+        compare_rankings);
+    qsort(pairs, 256 * 256, sizeof(struct ranking), compare_rankings);
+
+    fprintf(report,
+        ",- p ---------------------------------"
+        "-------------------------------------.\n"
+        "| loop        | source     |     itera"
+        "tions |                ticks |     %% |\n"
+        "|-------------------------------------"
+        "-------------------------------------|\n");
+
+    for (i = 0; i != number_of_loops && i != B_PROFILE_ROWS; ++i) {
+        size_t index = loops[i].index;
+
+        fprintf(report,
+            "| [x%08zX] | @%09" PRIu32 " | %14" PRIu64 " | %20" PRIu64
+            " | %5.1f |\n",
+            index, program->opcodes[index].position, profile->iterations[index],
+            profile->ticks[index],
+            profile->total != 0 ? 100.0 * profile->ticks[index] / profile->total
+                                : 0.0);
+    }
+
+    fprintf(report,
+        "|-------------------------------------"
+        "-------------------------------------|\n"
+        "| opcode      | instruction           "
+        "  | operand     | source     |     %% |\n"
+        "|-------------------------------------"
+        "-------------------------------------|\n");
+
+    for (i = 0; i != program->number_of_opcodes && i != B_PROFILE_ROWS &&
+         opcodes[i].key != 0;
+         ++i) {
+        size_t index = opcodes[i].index;
+
+        fprintf(report, "| [x%08zX] ", index);
+
+        /* The explanation of the end closes off its table. */
+        if (program->opcodes[index].instruction == B_TERMINATE) {
+            fprintf(report, "| terminate-execution     |      ~      |");
+        } else {
+            explain_opcode(report, program->opcodes + index);
+        }
+
+        fprintf(report, " @%09" PRIu32 " | %5.1f |\n",
+            program->opcodes[index].position,
+            executed != 0 ? 100.0 * opcodes[i].key / executed : 0.0);
+    }
+
+    fprintf(report,
+        "|-------------------------------------"
+        "-------------------------------------|\n"
+        "| pair                    | superinstr"
+        "uction       |   successions |     %% |\n"
+        "|-------------------------------------"
+        "-------------------------------------|\n");
+
+    for (i = 0; i != B_PROFILE_ROWS && pairs[i].key != 0; ++i) {
+        enum instruction first = pairs[i].index >> 8;
+        enum instruction second = pairs[i].index & 0xFF;
+
+        unsigned int code = find_superinstruction(first, second);
+
+        fprintf(report, "| %-11s %-11s | %-22s | %13" PRIu64 " | %5.1f |\n",
+            get_instruction_name(first), get_instruction_name(second),
+            code != 0 ? B_SUPERINSTRUCTIONS[code].name : "~",
+            pairs[i].key,
+            executed != 0 ? 100.0 * pairs[i].key / executed : 0.0);
+    }
+
+    fprintf(report,
+        "`-------------------------------------"
+        "-------------------------------------'\n"
+        "executed %" PRIu64 " opcodes in %" PRIu64 " ticks\n", executed,
+        profile->total);
+
+    free(pairs);
+    free(opcodes);
+    free(loops);
+
+    return B_SUCCESS;
+}
+
+/* The output buffer, the input cursor, the tape and the scan kernels of the
+ * interpreter, restated for the generated code. */
+static char const B_C_RUNTIME[] =
+    "static char output[65536];\n"
+    "static size_t output_length = 0;\n"
+    "\n"
+    "static void flush_output(void)\n"
+    "{\n"
+    "        fwrite(output, 1, output_length, stdout);\n"
+    "        fflush(stdout);\n"
+    "\n"
+    "        output_length = 0;\n"
+    "}\n"
+    "\n"
+    "static void write_output(int cell, size_t count)\n"
+    "{\n"
+    "        while (count != 0) {\n"
+    "                size_t length = sizeof(output) - output_length;\n"
+    "\n"
+    "                if (length > count) {\n"
+    "                        length = count;\n"
+    "                }\n"
+    "\n"
+    "                memset(output + output_length, cell, length);\n"
+    "\n"
+    "                output_length += length;\n"
+    "                count -= length;\n"
+    "\n"
+    "                if (output_length == sizeof(output)) {\n"
+    "                        flush_output();\n"
+    "                }\n"
+    "        }\n"
+    "}\n"
+    "\n"
+    "static void write_constant(unsigned char const *bytes, size_t length)\n"
+    "{\n"
+    "        if (length <= sizeof(output) - output_length) {\n"
+    "                memcpy(output + output_length, bytes, length);\n"
+    "                output_length += length;\n"
+    "\n"
+    "                return;\n"
+    "        }\n"
+    "\n"
+    "        flush_output();\n"
+    "        fwrite(bytes, 1, length, stdout);\n"
+    "        fflush(stdout);\n"
+    "}\n"
+    "\n"
+    "static unsigned char input[65536];\n"
+    "\n"
+    "static unsigned char const *input_cursor = input;\n"
+    "static unsigned char const *input_end = input;\n"
+    "\n"
+    "static int input_descriptor = STDIN_FILENO;\n"
+    "static int is_input_mapped = 0;\n"
+    "\n"
+    "static void open_input(char const *filename)\n"
+    "{\n"
+    "        struct stat status;\n"
+    "        void *contents = NULL;\n"
+    "\n"
+    "        input_descriptor = open(filename, O_RDONLY);\n"
+    "\n"
+    "        if (input_descriptor == -1 ||\n"
+    "                fstat(input_descriptor, &status) != 0) {\n"
+    "                perror(filename);\n"
+    "                exit(EXIT_FAILURE);\n"
+    "        }\n"
+    "\n"
+    "        is_input_mapped = 1;\n"
+    "\n"
+    "        if (status.st_size == 0) {\n"
+    "                return;\n"
+    "        }\n"
+    "\n"
+    "        contents = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE,\n"
+    "                input_descriptor, 0);\n"
+    "\n"
+    "        if (contents == MAP_FAILED) {\n"
+    "                perror(filename);\n"
+    "                exit(EXIT_FAILURE);\n"
+    "        }\n"
+    "\n"
+    "        madvise(contents, status.st_size, MADV_SEQUENTIAL);\n"
+    "\n"
+    "        input_cursor = contents;\n"
+    "        input_end = input_cursor + status.st_size;\n"
+    "}\n"
+    "\n"
+    "static int refill_input(void)\n"
+    "{\n"
+    "        ssize_t length = 0;\n"
+    "\n"
+    "        if (is_input_mapped) {\n"
+    "                return 0;\n"
+    "        }\n"
+    "\n"
+    "        flush_output();\n"
+    "\n"
+    "        do {\n"
+    "                length = read(input_descriptor, input, sizeof(input));\n"
+    "        } while (length == -1 && errno == EINTR);\n"
+    "\n"
+    "        if (length <= 0) {\n"
+    "                return 0;\n"
+    "        }\n"
+    "\n"
+    "        input_cursor = input;\n"
+    "        input_end = input + length;\n"
+    "\n"
+    "        return 1;\n"
+    "}\n"
+    "\n"
+    "static uint64_t read_input(uint64_t cell)\n"
+    "{\n"
+    "        (void) cell;\n"
+    "\n"
+    "        if (input_cursor == input_end && !refill_input()) {\n"
+    "                return END_OF_INPUT(cell);\n"
+    "        }\n"
+    "\n"
+    "        return *input_cursor++;\n"
+    "}\n"
+    "\n";
+
+static char const B_C_TAPE[] =
+    "static char *tape_begin = NULL;\n"
+    "static char *tape_end = NULL;\n"
+    "\n"
+    "static char *committed_begin = NULL;\n"
+    "static char *committed_end = NULL;\n"
+    "\n"
+    "static size_t granule = 0;\n"
+    "\n"
+    "static char *reservation = NULL;\n"
+    "static size_t reservation_length = 0;\n"
+    "\n"
+    "static struct sigaction previous_handler;\n"
+    "static char fault_stack[65536];\n"
+    "\n"
+    "static void exhaust_tape(void)\n"
+    "{\n"
+    "        static char const message[] = \"tape exhausted\\n\";\n"
+    "\n"
+    "        write(STDERR_FILENO, message, sizeof(message) - 1);\n"
+    "        abort();\n"
+    "}\n"
+    "\n"
+    "static int commit_tape(char *address)\n"
+    "{\n"
+    "        char *begin = committed_begin;\n"
+    "        char *end = committed_end;\n"
+    "\n"
+    "        size_t length = end - begin;\n"
+    "\n"
+    "        if (address < tape_begin || address >= tape_end) {\n"
+    "                return 0;\n"
+    "        }\n"
+    "\n"
+    "        if (address < begin) {\n"
+    "                begin = (char *) ((uintptr_t) address & ~(granule - 1));\n"
+    "\n"
+    "                if ((size_t) (committed_begin - tape_begin) <= length) {\n"
+    "                        begin = tape_begin;\n"
+    "                } else if (begin > committed_begin - length) {\n"
+    "                        begin = committed_begin - length;\n"
+    "                }\n"
+    "        } else if (address >= end) {\n"
+    "                end = (char *) (((uintptr_t) address + granule) &\n"
+    "                        ~(granule - 1));\n"
+    "\n"
+    "                if ((size_t) (tape_end - committed_end) <= length) {\n"
+    "                        end = tape_end;\n"
+    "                } else if (end < committed_end + length) {\n"
+    "                        end = committed_end + length;\n"
+    "                }\n"
+    "        } else {\n"
+    "                return 0;\n"
+    "        }\n"
+    "\n"
+    "        if (mprotect(begin, end - begin, PROT_READ | PROT_WRITE) != 0) {\n"
+    "                return 0;\n"
+    "        }\n"
+    "\n"
+    "        committed_begin = begin;\n"
+    "        committed_end = end;\n"
+    "\n"
+    "        return 1;\n"
+    "}\n"
+    "\n"
+    "static void handle_tape_fault(int number, siginfo_t *information,\n"
+    "        void *context)\n"
+    "{\n"
+    "        char *address = information->si_addr;\n"
+    "\n"
+    "        (void) number;\n"
+    "        (void) context;\n"
+    "\n"
+    "        if (commit_tape(address)) {\n"
+    "                return;\n"
+    "        }\n"
+    "\n"
+    "        if (address >= reservation &&\n"
+    "                address < reservation + reservation_length) {\n"
+    "                exhaust_tape();\n"
+    "        }\n"
+    "\n"
+    "        sigaction(SIGSEGV, &previous_handler, NULL);\n"
+    "}\n"
+    "\n"
+    "static char *allocate_tape(size_t length)\n"
+    "{\n"
+    "        struct sigaction action;\n"
+    "        stack_t stack;\n"
+    "\n"
+    "        char *origin = NULL;\n"
+    "        size_t extent = (size_t) 1 << 30;\n"
+    "\n"
+    "        granule = use_huge_pages ? (size_t) 1 << 21\n"
+    "                                 : (size_t) sysconf(_SC_PAGESIZE);\n"
+    "\n"
+    "        reservation_length = 2 * extent + 3 * granule;\n"
+    "        reservation = mmap(NULL, reservation_length, PROT_NONE,\n"
+    "                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);\n"
+    "\n"
+    "        if (reservation == MAP_FAILED) {\n"
+    "                perror(\"mmap\");\n"
+    "                exit(EXIT_FAILURE);\n"
+    "        }\n"
+    "\n"
+    "        origin = (char *) (((uintptr_t) reservation + granule + extent +\n"
+    "                granule - 1) & ~(granule - 1));\n"
+    "\n"
+    "        tape_begin = origin - extent;\n"
+    "        tape_end = origin + extent;\n"
+    "\n"
+    "#if defined(MADV_HUGEPAGE)\n"
+    "        if (use_huge_pages) {\n"
+    "                madvise(tape_begin, tape_end - tape_begin, MADV_HUGEPAGE);\n"
+    "        }\n"
+    "#endif\n"
+    "\n"
+    "        stack.ss_sp = fault_stack;\n"
+    "        stack.ss_size = sizeof(fault_stack);\n"
+    "        stack.ss_flags = 0;\n"
+    "\n"
+    "        sigaltstack(&stack, NULL);\n"
+    "\n"
+    "        memset(&action, 0, sizeof(action));\n"
+    "        action.sa_sigaction = handle_tape_fault;\n"
+    "        action.sa_flags = SA_SIGINFO | SA_ONSTACK;\n"
+    "        sigemptyset(&action.sa_mask);\n"
+    "\n"
+    "        sigaction(SIGSEGV, &action, &previous_handler);\n"
+    "\n"
+    "        committed_begin = origin;\n"
+    "        committed_end = origin;\n"
+    "\n"
+    "        if (length > extent) {\n"
+    "                length = extent;\n"
+    "        }\n"
+    "\n"
+    "        if (length != 0 && !commit_tape(origin + length - 1)) {\n"
+    "                perror(\"mprotect\");\n"
+    "                exit(EXIT_FAILURE);\n"
+    "        }\n"
+    "\n"
+    "        return origin;\n"
+    "}\n";
+
+static char const B_C_SCAN_KERNELS[] =
+    "#define LANES (16 / sizeof(cell))\n"
+    "\n"
+    "#if defined(__SSE2__) && defined(__GNUC__)\n"
+    "#include <emmintrin.h>\n"
+    "\n"
+    "static unsigned int get_stride_mask(size_t stride, int is_reversed)\n"
+    "{\n"
+    "        size_t i = 0;\n"
+    "        unsigned int mask = 0;\n"
+    "\n"
+    "        for (; i < LANES - LANES % stride; i += stride) {\n"
+    "                mask |= 1U << (is_reversed ? 15 - i * sizeof(cell)\n"
+    "                                           : i * sizeof(cell));\n"
+    "        }\n"
+    "\n"
+    "        return mask;\n"
+    "}\n"
+    "\n"
+    "static unsigned int get_zero_mask(cell const *pointer)\n"
+    "{\n"
+    "        __m128i cells = _mm_loadu_si128((__m128i const *) pointer);\n"
+    "        __m128i zeros = _mm_setzero_si128();\n"
+    "\n"
+    "        if (sizeof(cell) == 1) {\n"
+    "                zeros = _mm_cmpeq_epi8(cells, zeros);\n"
+    "        } else if (sizeof(cell) == 2) {\n"
+    "                zeros = _mm_cmpeq_epi16(cells, zeros);\n"
+    "        } else if (sizeof(cell) == 4) {\n"
+    "                zeros = _mm_cmpeq_epi32(cells, zeros);\n"
+    "        } else {\n"
+    "                zeros = _mm_cmpeq_epi32(cells, zeros);\n"
+    "                zeros = _mm_and_si128(zeros,\n"
+    "                        _mm_shuffle_epi32(zeros, _MM_SHUFFLE(2, 3, 0, 1)));\n"
+    "        }\n"
+    "\n"
+    "        return _mm_movemask_epi8(zeros);\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "static cell *scan_right(cell *pointer, size_t stride)\n"
+    "{\n"
+    "        cell const *end = (cell const *) tape_end;\n"
+    "\n"
+    "        if (sizeof(cell) == 1 && stride == 1 && pointer < end) {\n"
+    "                cell *found = memchr(pointer, 0, end - pointer);\n"
+    "\n"
+    "                if (found != NULL) {\n"
+    "                        return found;\n"
+    "                }\n"
+    "        }\n"
+    "\n"
+    "#if defined(__SSE2__) && defined(__GNUC__)\n"
+    "        if (stride <= LANES) {\n"
+    "                size_t step = LANES - LANES % stride;\n"
+    "                unsigned int mask = get_stride_mask(stride, 0);\n"
+    "\n"
+    "                while (pointer < end && (size_t) (end - pointer) >= LANES) {\n"
+    "                        unsigned int zeros = mask & get_zero_mask(pointer);\n"
+    "\n"
+    "                        if (zeros != 0) {\n"
+    "                                return pointer +\n"
+    "                                        __builtin_ctz(zeros) / sizeof(cell);\n"
+    "                        }\n"
+    "\n"
+    "                        pointer += step;\n"
+    "                }\n"
+    "        }\n"
+    "#endif\n"
+    "\n"
+    "        while (*pointer != 0) {\n"
+    "                pointer += stride;\n"
+    "        }\n"
+    "\n"
+    "        return pointer;\n"
+    "}\n"
+    "\n"
+    "static cell *scan_left(cell *pointer, size_t stride)\n"
+    "{\n"
+    "        cell const *begin = (cell const *) tape_begin;\n"
+    "\n"
+    "#if defined(__SSE2__) && defined(__GNUC__)\n"
+    "        if (stride <= LANES) {\n"
+    "                size_t step = LANES - LANES % stride;\n"
+    "                unsigned int mask = get_stride_mask(stride, 1);\n"
+    "\n"
+    "                while (pointer >= begin &&\n"
+    "                        (size_t) (pointer - begin) >= LANES - 1) {\n"
+    "                        unsigned int zeros =\n"
+    "                                mask & get_zero_mask(pointer - (LANES - 1));\n"
+    "\n"
+    "                        if (zeros != 0) {\n"
+    "                                return pointer - (__builtin_clz(zeros) - 16) /\n"
+    "                                        sizeof(cell);\n"
+    "                        }\n"
+    "\n"
+    "                        pointer -= step;\n"
+    "                }\n"
+    "        }\n"
+    "#endif\n"
+    "\n"
+    "        while (*pointer != 0) {\n"
+    "                pointer -= stride;\n"
+    "        }\n"
+    "\n"
+    "        return pointer;\n"
+    "}\n";
+
+/* Entry points into the runtime for a native executable.  The object emitted
+ * for it calls these rather than the static functions they wrap, and its own
+ * entry point is renamed to `brainfuck_main`. */
+static char const B_C_LINKAGE[] =
+    "\n"
+    "void brainfuck_main(void);\n"
+    "\n"
+    "uint64_t brainfuck_read_input(uint64_t cell)\n"
+    "{\n"
+    "        return read_input(cell);\n"
+    "}\n"
+    "\n"
+    "void brainfuck_write_output(int cell, size_t count)\n"
+    "{\n"
+    "        write_output(cell, count);\n"
+    "}\n"
+    "\n"
+    "void brainfuck_write_constant(unsigned char const *bytes, size_t length)\n"
+    "{\n"
+    "        write_constant(bytes, length);\n"
+    "}\n"
+    "\n"
+    "void brainfuck_flush_output(void)\n"
+    "{\n"
+    "        flush_output();\n"
+    "}\n"
+    "\n"
+    "void brainfuck_exhaust_tape(void)\n"
+    "{\n"
+    "        exhaust_tape();\n"
+    "}\n"
+    "\n"
+    "char *brainfuck_allocate_tape(size_t length)\n"
+    "{\n"
+    "        return allocate_tape(length);\n"
+    "}\n"
+    "\n"
+    "void brainfuck_free_tape(char *tape)\n"
+    "{\n"
+    "        (void) tape;\n"
+    "        munmap(reservation, reservation_length);\n"
+    "}\n"
+    "\n"
+    "int main(int count, char **arguments)\n"
+    "{\n"
+    "        if (count > 1) {\n"
+    "                open_input(arguments[1]);\n"
+    "        }\n"
+    "\n"
+    "        brainfuck_main();\n"
+    "        return 0;\n"
+    "}\n";
+
+static void emit_c_prologue(struct program const *program, FILE *file)
+{
+    struct brainfuck_options const *options = &program->options;
+
+    fprintf(file,
+        "/* %s */\n#define _GNU_SOURCE\n\n"
+        "#include <stdio.h>\n#include <stdlib.h>\n"
+        "#include <string.h>\n\n"
+        "#include <stdint.h>\n\n"
+        "#include <errno.h>\n#include <fcntl.h>\n#include <signal.h>\n"
+        "#include <sys/mman.h>\n#include <sys/stat.h>\n#include <unistd.h>\n"
+        "\n"
+        "typedef uint%d_t cell;\n"
+        "\n"
+        "static int use_huge_pages = %d;\n"
+        "\n",
+        program->name, options->cell_width, options->should_use_huge_pages);
+
+    if (options->should_keep_cell_at_end_of_input == B_TRUE) {
+        fputs("#define END_OF_INPUT(cell) (cell)\n\n", file);
+    } else {
+        fprintf(file, "#define END_OF_INPUT(cell) (%d)\n\n",
+            options->end_of_input_value);
+    }
+}
+
+static int has_instruction(
+    struct program const *program, enum instruction instruction)
+{
+    size_t i = 0;
+
+    for (; i != program->number_of_opcodes; ++i) {
+        if (program->opcodes[i].instruction == instruction) {
+            return B_TRUE;
+        }
+    }
+
+    return B_FALSE;
+}
+
+/* The runtime is emitted whole, apart from the scan kernels, so whatever
+ * part of it the program leaves unused is marked as used in `main`. */
+static void emit_c_unused_runtime(struct program const *program, FILE *file)
+{
+    static struct {
+        enum instruction instruction;
+        char const *name;
+    } const functions[] = {{B_OUTPUT_CELL_VALUE, "write_output"},
+        {B_OUTPUT_CONSTANT, "write_constant"},
+        {B_INPUT_CELL_VALUE, "read_input"}, {B_SCAN_LEFT, "scan_left"},
+        {B_SCAN_RIGHT, "scan_right"}};
+
+    int has_scans = has_instruction(program, B_SCAN_LEFT) == B_TRUE ||
+        has_instruction(program, B_SCAN_RIGHT) == B_TRUE;
+
+    size_t i = 0;
+
+    for (; i != sizeof(functions) / sizeof(functions[0]); ++i) {
+        if ((functions[i].instruction == B_SCAN_LEFT ||
+                functions[i].instruction == B_SCAN_RIGHT) &&
+            has_scans == B_FALSE) {
+            continue;
+        }
+
+        if (has_instruction(program, functions[i].instruction) == B_FALSE) {
+            fprintf(file, "        (void) %s;\n", functions[i].name);
+        }
+    }
+}
+
+static enum brainfuck_status emit_c_code(
+    struct program const *program, char const *filename)
+{
+    size_t i = 0;
+
+    FILE *file = fopen(filename, "wt");
+
+    if (file == NULL) {
+        return B_CANNOT_WRITE;
+    }
+
+    emit_c_prologue(program, file);
+    fputs("static cell *pointer = NULL;\n\n", file);
+
+    fputs(B_C_RUNTIME, file);
+    fputs(B_C_TAPE, file);
+
+    if (has_instruction(program, B_SCAN_LEFT) == B_TRUE ||
+        has_instruction(program, B_SCAN_RIGHT) == B_TRUE) {
+        fputs(B_C_SCAN_KERNELS, file);
+    }
+
+    if (program->constants_length != 0) {
+        fputs("\nstatic unsigned char const constants[] = {", file);
+
+        for (i = 0; i != program->constants_length; ++i) {
+            fprintf(file, "%s%u,", (i % 16 == 0) ? "\n        " : " ",
+                program->constants[i]);
+        }
+
+        fputs("\n};\n", file);
+        i = 0;
+    }
+
+    fputs(
+        "\n"
+        "int main(int count, char **arguments)\n"
+        "{\n"
+        "        if (count > 1) {\n"
+        "                open_input(arguments[1]);\n"
+        "        }\n"
+        "\n",
+        file);
+
+    emit_c_unused_runtime(program, file);
+
+    fprintf(file,
+        "        pointer = (cell *) allocate_tape(%zd * sizeof(cell));\n\n",
+        program->options.container_length);
+
+    for (; i != program->number_of_opcodes; ++i) {
+        switch (program->opcodes[i].instruction) {
+        case B_MOVE_POINTER_LEFT:
+            fputs("        ", file);
+            fprintf(file, "pointer -= %zd;\n", program->opcodes[i].auxiliary);
+            break;
+
+        case B_MOVE_POINTER_RIGHT:
+            fputs("        ", file);
+            fprintf(file, "pointer += %zd;\n", program->opcodes[i].auxiliary);
+            break;
+
+        case B_INCREMENT_CELL_VALUE:
+            fputs("        ", file);
+            fprintf(file, "pointer[%ld] += %zd;\n", program->opcodes[i].offset,
+                program->opcodes[i].auxiliary);
+            break;
+
+        case B_DECREMENT_CELL_VALUE:
+            fputs("        ", file);
+            fprintf(file, "pointer[%ld] -= %zd;\n", program->opcodes[i].offset,
+                program->opcodes[i].auxiliary);
+            break;
+
+        case B_OUTPUT_CELL_VALUE:
+            fputs("        ", file);
+            fprintf(file,
+                "write_output((unsigned char) pointer[%ld], %zd);\n",
+                program->opcodes[i].offset, program->opcodes[i].auxiliary);
+            break;
+
+        case B_INPUT_CELL_VALUE:
+            fputs("        ", file);
+            fprintf(file, "pointer[%ld] = read_input(pointer[%ld]);\n",
+                program->opcodes[i].offset, program->opcodes[i].offset);
+            break;
+
+        case B_SET_CELL_VALUE:
+            fputs("        ", file);
+            fprintf(file, "pointer[%ld] = %zd;\n", program->opcodes[i].offset,
+                program->opcodes[i].auxiliary);
+            break;
+
+        case B_MULTIPLY_CELL_VALUE:
+            fputs("        ", file);
+            fprintf(file, "pointer[%ld] += pointer[%ld] * (uint64_t) %zd;\n",
+                program->opcodes[i].offset, program->opcodes[i].source,
+                program->opcodes[i].auxiliary);
+            break;
+
+        case B_SCAN_LEFT:
+            fputs("        ", file);
+            fprintf(file, "pointer = scan_left(pointer, %zd);\n",
+                program->opcodes[i].auxiliary);
+            break;
+
+        case B_SCAN_RIGHT:
+            fputs("        ", file);
+            fprintf(file, "pointer = scan_right(pointer, %zd);\n",
+                program->opcodes[i].auxiliary);
+            break;
+
+        case B_OUTPUT_CONSTANT:
+            fputs("        ", file);
+            fprintf(file, "write_constant(constants + %ld, %zd);\n",
+                program->opcodes[i].offset, program->opcodes[i].auxiliary);
+            break;
+
+        case B_CHECK_TAPE:
+            fputs("        ", file);
+            fprintf(file,
+                "if ((char *) (pointer + %ld) < tape_begin ||\n"
+                "                (char *) (pointer + %ld) >= tape_end) {\n"
+                "                exhaust_tape();\n"
+                "        }\n",
+                program->opcodes[i].offset, program->opcodes[i].source);
+            break;
+
+        case B_BRANCH_FORWARD:
+            fprintf(file, "\nl%zd:\n", i);
+
+            fputs("        ", file);
+            fprintf(file,
+                "if (*pointer == 0) {\n"
+                "                goto l%zd;\n"
+                "        }\n\n",
+                program->opcodes[i].auxiliary);
+
+            break;
+
+        case B_BRANCH_BACKWARD:
+            fputs("\n        ", file);
+            fprintf(file,
+                "if (*pointer != 0) {\n"
+                "                goto l%zd;\n"
+                "        }\n\n",
+                program->opcodes[i].auxiliary);
+
+            fprintf(file, "l%zd:\n", i);
+
+        default:
+            break;
+        }
+    }
+
+    fputs("\n        flush_output();\n        return 0;\n}\n", file);
+
+    if (ferror(file) != 0) {
+        fclose(file);
+        return B_CANNOT_WRITE;
+    }
+
+    return (fclose(file) == 0) ? B_SUCCESS : B_CANNOT_WRITE;
+}
+
+static enum brainfuck_status emit_llvm_ir(
+    struct program const *program, char const *filename)
+{
+    enum brainfuck_status status = B_SUCCESS;
+    char *error = NULL;
+
+    LLVMContextRef context = LLVMContextCreate();
+    LLVMModuleRef module = build_llvm_module(program, context);
+
+    if (module == NULL) {
+        LLVMContextDispose(context);
+        return B_COMPILATION_FAILED;
+    }
+
+    if (LLVMPrintModuleToFile(module, filename, &error) != 0) {
+        status = B_CANNOT_WRITE;
+    }
+
+    LLVMDisposeMessage(error);
+    LLVMDisposeModule(module);
+    LLVMContextDispose(context);
+
+    return status;
+}
+
+/* Compiles the module to an object with the target machine and, unless an
+ * object is all that was asked for, links it with the runtime of the
+ * generated C code into a standalone executable.  Linking goes through `cc`,
+ * or whatever `CC` names. */
+static enum brainfuck_status link_executable(
+    struct program const *program, char const *object, char const *filename)
+{
+    char runtime[] = "/tmp/brainfuckXXXXXX.c";
+    char const *compiler = getenv("CC");
+
+    int descriptor = mkstemps(runtime, 2);
+    int status = 0;
+
+    FILE *file = NULL;
+    pid_t child = 0;
+
+    if (descriptor == -1) {
+        return B_CANNOT_WRITE;
+    }
+
+    if ((file = fdopen(descriptor, "w")) == NULL) {
+        close(descriptor);
+        unlink(runtime);
+
+        return B_CANNOT_WRITE;
+    }
+
+    emit_c_prologue(program, file);
+
+    fputs(B_C_RUNTIME, file);
+    fputs(B_C_TAPE, file);
+    fputs(B_C_LINKAGE, file);
+
+    fclose(file);
+
+    if (compiler == NULL || compiler[0] == '\0') {
+        compiler = "cc";
+    }
+
+    child = fork();
+
+    if (child == 0) {
+        execlp(compiler, compiler, "-O2", "-o", filename, runtime, object,
+            (char *) NULL);
+
+        perror(compiler);
+        _exit(EXIT_FAILURE);
+    }
+
+    if (child == -1 || waitpid(child, &status, 0) == -1 ||
+        !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        unlink(runtime);
+        return B_COMPILATION_FAILED;
+    }
+
+    unlink(runtime);
+    return B_SUCCESS;
+}
+
+/* The optimizer drops declarations that end up unused, so what is left of
+ * the runtime is renamed to the names the linkage expects. */
+static void rename_runtime_functions(LLVMModuleRef module)
+{
+    static char const *const names[] = {"main", "read_input", "write_output",
+        "write_constant", "flush_output", "exhaust_tape", "allocate_tape",
+        "free_tape"};
+
+    size_t i = 0;
+
+    for (; i != sizeof(names) / sizeof(*names); ++i) {
+        LLVMValueRef function = LLVMGetNamedFunction(module, names[i]);
+        char name[32];
+
+        if (function != NULL) {
+            snprintf(name, sizeof(name), "brainfuck_%s", names[i]);
+            LLVMSetValueName2(function, name, strlen(name));
+        }
+    }
+}
+
+static enum brainfuck_status emit_executable(
+    struct program const *program, char const *filename)
+{
+    LLVMContextRef context = LLVMContextCreate();
+    LLVMModuleRef module = build_llvm_module(program, context);
+    LLVMTargetMachineRef machine =
+        create_target_machine(program, LLVMRelocPIC, LLVMCodeModelDefault);
+
+    enum brainfuck_status status = B_SUCCESS;
+
+    char object[] = "/tmp/brainfuckXXXXXX.o";
+    char *error = NULL;
+
+    size_t length = strlen(filename);
+    int is_object = length > 2 && strcmp(filename + length - 2, ".o") == 0;
+    int descriptor = -1;
+
+    if (module == NULL || machine == NULL) {
+        status = B_COMPILATION_FAILED;
+    } else if (is_object == B_FALSE &&
+               (descriptor = mkstemps(object, 2)) == -1) {
+        status = B_CANNOT_WRITE;
+    } else {
+        if (descriptor != -1) {
+            close(descriptor);
+        }
 
-            LLVMBuildStore(builder, decrement, cell);
-            break;
+        rename_runtime_functions(module);
+
+        if (LLVMTargetMachineEmitToFile(machine, module,
+                is_object ? (char *) filename : object, LLVMObjectFile,
+                &error) != 0) {
+            status = B_CANNOT_WRITE;
+        } else if (is_object == B_FALSE) {
+            status = link_executable(program, object, filename);
         }
 
-        case B_OUTPUT_CELL_VALUE: {
-            LLVMValueRef offset = LLVMBuildLoad(builder, index, "");
+        if (is_object == B_FALSE) {
+            unlink(object);
+        }
+    }
 
-            LLVMValueRef cell =
-                LLVMBuildGEP(builder, container, &offset, 1, "");
+    LLVMDisposeMessage(error);
 
-            LLVMValueRef value = LLVMBuildLoad(builder, cell, "");
-            LLVMValueRef character =
-                LLVMBuildSExt(builder, value, LLVMInt32Type(), "");
+    if (machine != NULL) {
+        LLVMDisposeTargetMachine(machine);
+    }
 
-            LLVMValueRef function = LLVMGetNamedFunction(module, "putchar");
+    if (module != NULL) {
+        LLVMDisposeModule(module);
+    }
 
-            LLVMBuildCall(builder, function, &character, 1, "");
-            break;
-        }
+    LLVMContextDispose(context);
+    return status;
+}
 
-        case B_INPUT_CELL_VALUE: {
-            LLVMValueRef function = LLVMGetNamedFunction(module, "getchar");
+/* A compiled program: the optimized opcodes and their bytecode, along with
+ * whatever native code was asked for up front.  None of it changes once
+ * compiled, so any number of runs can share it. */
+struct brainfuck_program {
+    struct program *program;
+    struct bytecode *bytecode;
+    char *cache_directory;
 
-            LLVMValueRef input = LLVMBuildCall(builder, function, NULL, 0, "");
+    LLVMOrcLLJITRef jit;
+    void (*compiled)(void);
 
-            LLVMValueRef character =
-                LLVMBuildTrunc(builder, input, LLVMInt8Type(), "");
+    assembled_program assembled;
+    size_t assembled_length;
 
-            LLVMValueRef offset = LLVMBuildLoad(builder, index, "");
+    struct brainfuck_statistics statistics;
+};
 
-            LLVMValueRef cell =
-                LLVMBuildGEP(builder, container, &offset, 1, "");
+void brainfuck_set_default_options(struct brainfuck_options *options)
+{
+    if (options == NULL) {
+        abort();
+    }
 
-            LLVMBuildStore(builder, character, cell);
-            break;
-        }
+    memset(options, 0, sizeof(struct brainfuck_options));
 
-        case B_BRANCH_FORWARD: {
-            LLVMBasicBlockRef body = NULL;
+    options->cell_width = 8;
+    options->should_optimize = B_TRUE;
+    options->optimization_level = 3;
 
-            LLVMValueRef offset = NULL;
-            LLVMValueRef cell = NULL;
-            LLVMValueRef value = NULL;
-            LLVMValueRef predicate = NULL;
+    options->evaluation_budget = B_EVALUATION_BUDGET;
 
-            LLVMValueRef zero = LLVMConstInt(LLVMInt8Type(), 0, B_FALSE);
+    options->end_of_input_value = -1;
+    options->container_length = 30000;
+}
 
-            LLVMValueRef main = LLVMGetNamedFunction(module, "main");
+char const *brainfuck_describe_status(enum brainfuck_status status)
+{
+    switch (status) {
+    case B_SUCCESS:
+        return "success";
 
-            start = LLVMAppendBasicBlock(main, "start");
-            stack[k++] = start;
+    case B_OUT_OF_MEMORY:
+        return "out of memory";
 
-            body = LLVMAppendBasicBlock(main, "body");
+    case B_NOTHING_TO_DO:
+        return "nothing to do";
 
-            end = LLVMAppendBasicBlock(main, "end");
-            stack[k++] = end;
+    case B_UNMATCHED_BRACKET:
+        return "unmatched bracket";
 
-            LLVMBuildBr(builder, start);
-            LLVMPositionBuilderAtEnd(builder, start);
+    case B_PROGRAM_TOO_LARGE:
+        return "too many wide opcodes";
 
-            offset = LLVMBuildLoad(builder, index, "");
-            cell = LLVMBuildGEP(builder, container, &offset, 1, "");
+    case B_CANNOT_READ:
+        return "cannot read";
 
-            value = LLVMBuildLoad(builder, cell, "");
-            predicate = LLVMBuildICmp(builder, LLVMIntEQ, value, zero, "");
+    case B_CANNOT_WRITE:
+        return "cannot write";
 
-            LLVMBuildCondBr(builder, predicate, end, body);
+    case B_TAPE_EXHAUSTED:
+        return "tape exhausted";
 
-            LLVMPositionBuilderAtEnd(builder, body);
-            break;
-        }
+    case B_COMPILATION_FAILED:
+        return "compilation failed";
 
-        case B_BRANCH_BACKWARD: {
-            end = stack[--k];
-            start = stack[--k];
+    case B_UNSUPPORTED:
+        return "unsupported";
 
-            LLVMBuildBr(builder, start);
-            LLVMPositionBuilderAtEnd(builder, end);
+    case B_TIMED_OUT:
+        return "timed out";
 
-            break;
-        }
+    case B_STEP_LIMIT_EXCEEDED:
+        return "step limit exceeded";
 
-        case B_TERMINATE:
-        default:
-            break;
-        }
+    default:
+        return "unknown status";
     }
+}
 
-    LLVMBuildFree(builder, container);
-    LLVMBuildRetVoid(builder);
+void brainfuck_destroy_program(struct brainfuck_program *program)
+{
+    if (program != NULL) {
+        if (program->jit != NULL) {
+            LLVMConsumeError(LLVMOrcDisposeLLJIT(program->jit));
+        }
 
-    LLVMDisposeBuilder(builder);
+        if (program->assembled != NULL) {
+            munmap((void *) program->assembled, program->assembled_length);
+        }
 
-    free(stack);
+        free(program->cache_directory);
+        free_bytecode(program->bytecode);
+        free_program(program->program);
+    }
 
-    return optimize_llvm_module(module);
+    free(program);
 }
 
-static void execute(struct program const *program)
+/* Everything that comes after loading: the passes, the bytecode and the
+ * native code the options ask for. */
+static enum brainfuck_status prepare_program(
+    struct brainfuck_program *handle, double start)
 {
-    LLVMExecutionEngineRef engine = NULL;
-    char *error = NULL;
+    struct program *program = handle->program;
+    struct brainfuck_statistics *statistics = &handle->statistics;
 
-    LLVMModuleRef module = build_llvm_module(program);
+    enum brainfuck_status status = B_SUCCESS;
 
-    fputs("executing:\n", stderr);
-    LLVMDumpModule(module);
+    statistics->source_length = program->source_length;
+    statistics->number_of_opcodes = program->number_of_opcodes;
+    statistics->loading_time = get_time() - start;
 
-    fputc('\n', stderr);
-    fflush(stderr);
+    if (program->options.should_optimize == B_TRUE) {
+        program = eliminate_multiply_loops(program);
+        program = recognize_idioms(program);
+        program = sink_pointer_movement(program);
 
-    LLVMVerifyModule(module, LLVMAbortProcessAction, &error);
+        handle->program = program;
 
-    LLVMDisposeMessage(error);
-    error = NULL;
+        if ((status = link_branches(program)) != B_SUCCESS) {
+            return status;
+        }
 
-    LLVMInitializeNativeTarget();
+        start = get_time();
+        status = evaluate_prefix(program, statistics);
+        statistics->evaluation_time = get_time() - start;
 
-    LLVMInitializeNativeAsmPrinter();
-    LLVMInitializeNativeAsmParser();
+        if (status != B_SUCCESS) {
+            return status;
+        }
+    }
 
-    if (LLVMCreateExecutionEngineForModule(&engine, module, &error) != 0) {
-        abort();
+    if (program->options.should_check_tape == B_TRUE &&
+        (status = insert_tape_checks(
+             program, &statistics->number_of_tape_checks)) != B_SUCCESS) {
+        return status;
     }
 
-    if (error != NULL) {
-        fprintf(stderr, "error: %s\n", error);
-        LLVMDisposeMessage(error);
+    if ((status = encode_program(program, &handle->bytecode)) != B_SUCCESS) {
+        return status;
+    }
 
-        abort();
+    if (program->options.should_compile == B_TRUE &&
+        (status = compile_program(program, statistics, &handle->jit,
+             &handle->compiled)) != B_SUCCESS) {
+        return status;
     }
 
-    puts("output:");
+    if (program->options.should_assemble == B_TRUE) {
+        start = get_time();
 
-    LLVMValueRef main = LLVMGetNamedFunction(module, "main");
-    LLVMRunFunction(engine, main, 0, NULL);
+        status = assemble(
+            program, &handle->assembled, &handle->assembled_length);
+        statistics->assembly_time = get_time() - start;
+    }
 
-    LLVMDisposeModule(module);
+    return status;
 }
 
-static void disassamble(struct program const *program)
+/* Both ways in: the program is loaded with `load` and the rest is the same.
+ * The name is the one generated C code is labelled with. */
+static enum brainfuck_status compile(char const *name, char const *source,
+    size_t length, struct brainfuck_options const *options,
+    struct brainfuck_program **result, size_t *position)
 {
-    size_t i = 0;
+    struct brainfuck_program *handle = NULL;
+    struct brainfuck_options copy;
 
-    if (program == NULL || program->opcodes == NULL) {
+    enum brainfuck_status status = B_SUCCESS;
+    double start = get_time();
+
+    if (options == NULL || result == NULL) {
         abort();
     }
 
-    printf(",- b -----------------------.\n");
-
-    for (; i != program->number_of_opcodes; ++i) {
-        if (program->opcodes[i].instruction == B_TERMINATE) {
-            break;
-        }
-
-        printf("| 0x%08zX | %05zd:%02d | %c |\n", i,
-            program->opcodes[i].auxiliary, program->opcodes[i].instruction,
-            program->opcodes[i].instruction);
+    if ((options->cell_width != 8 && options->cell_width != 16 &&
+            options->cell_width != 32 && options->cell_width != 64) ||
+        options->optimization_level < 0 || options->optimization_level > 3 ||
+        options->container_length == 0) {
+        return B_UNSUPPORTED;
     }
 
-    printf("\\-------~ ......... ~-------/\n");
-}
-
-static void explain_opcode(struct opcode const *opcode)
-{
-    if (opcode == NULL) {
-        abort();
+    if ((handle = calloc(1, sizeof(struct brainfuck_program))) == NULL) {
+        return B_OUT_OF_MEMORY;
     }
 
-    switch (opcode->instruction) {
-    case B_MOVE_POINTER_LEFT:
-        printf("| move-pointer-left       |   (%05zd)   |", opcode->auxiliary);
-        break;
+    copy = *options;
 
-    case B_MOVE_POINTER_RIGHT:
-        printf("| move-pointer-right      |   (%05zd)   |", opcode->auxiliary);
-        break;
+    if (options->cache_directory != NULL &&
+        (handle->cache_directory = strdup(options->cache_directory)) == NULL) {
+        free(handle);
+        return B_OUT_OF_MEMORY;
+    }
 
-    case B_INCREMENT_CELL_VALUE:
-        printf("| increment-cell-value    |   (%05zd)   |", opcode->auxiliary);
-        break;
+    copy.cache_directory = handle->cache_directory;
 
-    case B_DECREMENT_CELL_VALUE:
-        printf("| decrement-cell-value    |   (%05zd)   |", opcode->auxiliary);
-        break;
+    if (source != NULL) {
+        status =
+            load_source(source, length, &copy, &handle->program, position);
+    } else if (name != NULL) {
+        status = load_file(name, &copy, &handle->program, position);
+    } else {
+        status = load_stdin(&copy, &handle->program, position);
+    }
 
-    case B_OUTPUT_CELL_VALUE:
-        printf("| output-cell-value       |      ~      |");
-        break;
+    if (status == B_SUCCESS &&
+        (handle->program->name = strdup(name != NULL ? name : "stdin")) ==
+            NULL) {
+        status = B_OUT_OF_MEMORY;
+    }
 
-    case B_INPUT_CELL_VALUE:
-        printf("| input-cell-value        |      ~      |");
-        break;
+    if (status == B_SUCCESS) {
+        status = prepare_program(handle, start);
+    }
 
-    case B_BRANCH_FORWARD:
-        printf("| branch-if-zero          | [x%08zX] |", opcode->auxiliary);
-        break;
+    if (status != B_SUCCESS) {
+        brainfuck_destroy_program(handle);
+        return status;
+    }
 
-    case B_BRANCH_BACKWARD:
-        printf("| branch-back-if-not-zero | [x%08zX] |", opcode->auxiliary);
-        break;
+    *result = handle;
+    return B_SUCCESS;
+}
 
-    case B_TERMINATE:
-        printf("| terminate-execution ------------------/");
+enum brainfuck_status brainfuck_compile(char const *source, size_t length,
+    struct brainfuck_options const *options,
+    struct brainfuck_program **program, size_t *position)
+{
+    if (source == NULL) {
+        abort();
+    }
 
-    default:
-        break;
+    if (length == 0) {
+        return B_NOTHING_TO_DO;
     }
+
+    return compile("source", source, length, options, program, position);
 }
 
-static void explain(struct program const *program)
+enum brainfuck_status brainfuck_compile_file(char const *filename,
+    struct brainfuck_options const *options,
+    struct brainfuck_program **program, size_t *position)
 {
-    size_t i = 0;
+    return compile(filename, NULL, 0, options, program, position);
+}
 
-    if (program == NULL || program->opcodes == NULL) {
+void brainfuck_get_statistics(struct brainfuck_program const *program,
+    struct brainfuck_statistics *statistics)
+{
+    if (program == NULL || statistics == NULL) {
         abort();
     }
 
-    printf(",- b -----------------------------------.\n");
-    printf("| (): relative | []: absolute | ~: n/a  |\n");
-    printf("|---------------------------------------|\n");
-
-    for (; i != program->number_of_opcodes; ++i) {
-        explain_opcode(program->opcodes + i);
-        putchar('\n');
-    }
+    *statistics = program->statistics;
 }
 
-static void emit_c_code(struct program const *program, char const *filename)
+/* Everything after the jump target lives in the run, which nothing changes
+ * once the run is under way.  Timeouts are deferred outside of it. */
+static enum brainfuck_status execute(struct brainfuck_program const *handle,
+    enum brainfuck_engine engine, struct run *run,
+    struct brainfuck_run_statistics *statistics)
 {
-    size_t i = 0;
+    struct interpreter const *interpreter = NULL;
+    char *tape = run->tape->origin;
 
-    FILE *file = fopen(filename, "wt");
+    enum brainfuck_status status = sigsetjmp(run->exit, 1);
 
-    if (file == NULL) {
-        abort();
-    }
+    /* Whatever was written before the run stopped still goes out, but only
+     * once and without jumping back here if it cannot. */
+    if (status != B_SUCCESS) {
+        defer_timeout(run);
 
-    fprintf(file,
-        "/* %s */\n#include <stdio.h>\n\n"
-        "static char container[%zd];\n"
-        "static char *pointer = container;\n"
-        "\n"
-        "int main(int count, char **arguments)\n"
-        "{\n",
-        B_INPUT_FILENAME, B_CONTAINER_LENGTH);
+        if (status != B_CANNOT_WRITE && run->output_length != 0 &&
+            run->io->write != NULL) {
+            run->io->write(run->io->context,
+                (unsigned char const *) run->output, run->output_length);
+        }
 
-    for (; i != program->number_of_opcodes; ++i) {
-        switch (program->opcodes[i].instruction) {
-        case B_MOVE_POINTER_LEFT:
-            fputs("        ", file);
-            fprintf(file, "pointer -= %zd;\n", program->opcodes[i].auxiliary);
-            break;
+        run->output_length = 0;
 
-        case B_MOVE_POINTER_RIGHT:
-            fputs("        ", file);
-            fprintf(file, "pointer += %zd;\n", program->opcodes[i].auxiliary);
-            break;
+        return status;
+    }
 
-        case B_INCREMENT_CELL_VALUE:
-            fputs("        ", file);
-            fprintf(file, "*pointer += %zd;\n", program->opcodes[i].auxiliary);
-            break;
+    resume_timeout(run);
+    interpreter = get_interpreter(run->program);
 
-        case B_DECREMENT_CELL_VALUE:
-            fputs("        ", file);
-            fprintf(file, "*pointer -= %zd;\n", program->opcodes[i].auxiliary);
+    if (run->profile != NULL) {
+        interpreter->interpret_profiled(
+            run->program, run->profile, run->step_limit, tape);
+    } else {
+        switch (engine) {
+        case B_SWITCH_ENGINE:
+            statistics->number_of_executed_opcodes = interpreter->interpret(
+                run->program, NULL, run->step_limit, tape);
             break;
 
-        case B_OUTPUT_CELL_VALUE:
-            fputs("        ", file);
-            fputs("putchar(*pointer);\n", file);
+        case B_TIERED_ENGINE:
+            interpreter->interpret(run->program, run->tier, UINT64_MAX, tape);
             break;
 
-        case B_INPUT_CELL_VALUE:
-            fputs("        ", file);
-            fputs("*pointer = getchar();\n", file);
+        case B_THREADED_ENGINE:
+            interpreter->interpret_threaded(run->program, tape, run->handlers);
             break;
 
-        case B_BRANCH_FORWARD:
-            fprintf(file, "\nl%zd:\n", i);
-
-            fputs("        ", file);
-            fprintf(file,
-                "if (*pointer == 0) {\n"
-                "                goto l%zd;\n"
-                "        }\n\n",
-                program->opcodes[i].auxiliary);
-
+        case B_COMPILED_ENGINE:
+            handle->compiled();
             break;
 
-        case B_BRANCH_BACKWARD:
-            fputs("\n        ", file);
-            fprintf(file,
-                "if (*pointer != 0) {\n"
-                "                goto l%zd;\n"
-                "        }\n\n",
-                program->opcodes[i].auxiliary);
-
-            fprintf(file, "l%zd:\n", i);
+        case B_ASSEMBLED_ENGINE:
+            handle->assembled(tape);
+            break;
 
         default:
-            break;
+            interpreter->interpret_compact(handle->bytecode, tape);
         }
     }
 
-    fputs("\n        return 0;\n}\n", file);
-    fclose(file);
+    flush_output();
+    defer_timeout(run);
+
+    return B_SUCCESS;
 }
 
-static void emit_llvm_ir(struct program const *program, char const *filename)
+/* Runs the program on the tape with the engine, or with the profiled
+ * interpreter when there is a profile. */
+static enum brainfuck_status run_program(struct brainfuck_program const *handle,
+    enum brainfuck_engine engine, struct profile *profile,
+    struct brainfuck_tape *tape, struct brainfuck_io const *io,
+    struct brainfuck_limits const *limits,
+    struct brainfuck_run_statistics *statistics)
 {
-    char *error = NULL;
-    LLVMModuleRef module = build_llvm_module(program);
+    struct brainfuck_limits const none = {0, 0.0, 0};
 
-    if (filename == NULL) {
-        abort();
-    }
+    struct program const *program = handle->program;
 
-    LLVMPrintModuleToFile(module, filename, &error);
+    struct brainfuck_io const nothing = {NULL, 0, NULL, NULL, NULL};
+    struct brainfuck_run_statistics ignored;
 
-    if (error != NULL) {
-        fprintf(stderr, "error: %s\n", error);
-        LLVMDisposeMessage(error);
+    struct run *run = NULL;
+    enum brainfuck_status status = B_SUCCESS;
 
+    if (tape == NULL) {
         abort();
     }
 
-    LLVMDisposeModule(module);
-}
+    if (limits == NULL) {
+        limits = &none;
+    }
 
-static inline void free_program(struct program *program)
-{
-    if (program != NULL) {
-        free(program->opcodes);
+    if (statistics == NULL) {
+        statistics = &ignored;
     }
 
-    free(program);
-}
+    memset(statistics, 0, sizeof(struct brainfuck_run_statistics));
 
-static void display_help_screen(void)
-{
-    printf(
-        "    dP                         oo          .8888b             "
-        "      dP\n    88                                     88   \" "
-        "                  88\n    88d888b. 88d888b. .d8888b. dP 88d88"
-        "8b. 88aaa  dP    dP .d8888b. 88  .dP\n    88'  `88 88'  `88 8"
-        "8'  `88 88 88'  `88 88     88    88 88'  `\"\" 88888\"\n    8"
-        "8.  .88 88       88.  .88 88 88    88 88     88.  .88 88.  .."
-        ". 88  `8b.\n    88Y8888' dP       `88888P8 dP dP    dP dP    "
-        " `88888P' `88888P' dP   `YP\n"
-        "\n"
-        "Authored in 2013.  See README for a list of contributors.\n"
-        "Released into the public domain.\n"
-        "\n"
-        "Usage:\n"
-        "        %s [--cdehlruvxz] <input>\n"
-        "\n"
-        "Options:\n"
-        "        --                          read input from stdin\n"
-        "        -c [filename=`brainfuck.c`] generate and emit C "
-        "code\n"
-        "        -d                          print disassembly\n"
-        "        -e                          explain source code\n"
-        "        -h                          display this help "
-        "screen\n"
-        "        -l [filename=`brainfuck.l`] generate and emit LLVM "
-        "IR\n"
-        "        -r                          JIT compile and execute\n"
-        "        -u                          disable optimizations\n"
-        "        -v                          display version "
-        "information\n"
-        "        -x                          disable interpretation\n"
-        "        -z <length=`30000`>         set tape length\n",
-        B_INVOCATION);
-}
-
-static void parse_command_line(int count, char **arguments)
-{
-    int i = 1;
-
-    for (; i < count; ++i) {
-        switch (arguments[i][0]) {
-        case '-':
-            switch (arguments[i][1]) {
-            case '-':
-                B_SHOULD_READ_FROM_STDIN = B_TRUE;
-                break;
+    if ((engine == B_COMPILED_ENGINE && handle->compiled == NULL) ||
+        (engine == B_ASSEMBLED_ENGINE && handle->assembled == NULL) ||
+        (limits->step_limit != 0 && engine != B_SWITCH_ENGINE)) {
+        return B_UNSUPPORTED;
+    }
 
-            case 'c':
-                B_SHOULD_EMIT_C_CODE = B_TRUE;
+    /* The opcodes evaluated while compiling were steps of every run. */
+    if (limits->step_limit != 0 &&
+        handle->statistics.number_of_evaluated_opcodes > limits->step_limit) {
+        return B_STEP_LIMIT_EXCEEDED;
+    }
 
-                if (i + 1 < count) {
-                    if (arguments[i + 1][0] != '\0') {
-                        B_C_CODE_FILENAME = arguments[++i];
-                    }
-                }
-                break;
+    if ((run = calloc(1, sizeof(struct run))) == NULL) {
+        return B_OUT_OF_MEMORY;
+    }
 
-            case 'd':
-                B_SHOULD_PRINT_BYTECODE_DISASSEMBLY = B_TRUE;
-                break;
+    if (engine == B_THREADED_ENGINE &&
+        (run->handlers = malloc(
+             sizeof(void *) * program->number_of_opcodes)) == NULL) {
+        free(run);
+        return B_OUT_OF_MEMORY;
+    }
 
-            case 'e':
-                B_SHOULD_EXPLAIN_CODE = B_TRUE;
-                break;
+    if (engine == B_TIERED_ENGINE && profile == NULL &&
+        (status = start_tier(program, &run->tier)) != B_SUCCESS) {
+        free(run->handlers);
+        free(run);
 
-            case 'h':
-                display_help_screen();
-                break;
+        return status;
+    }
 
-            case 'l':
-                B_SHOULD_EMIT_LLVM_IR = B_TRUE;
+    if (tape->is_dirty == B_TRUE) {
+        memset(tape->committed_begin, 0,
+            tape->committed_end - tape->committed_begin);
+    }
 
-                if (i + 1 < count) {
-                    if (arguments[i + 1][0] != '\0') {
-                        B_LLVM_IR_FILENAME = arguments[++i];
-                    }
-                }
-                break;
+    tape->is_dirty = B_TRUE;
+    tape->limit = (limits->tape_limit + tape->granule - 1) &
+        ~(tape->granule - 1);
 
-            case 'r':
-                B_SHOULD_COMPILE_AND_EXECUTE = B_TRUE;
-                break;
+    run->program = program;
+    run->tape = tape;
+    run->io = (io != NULL) ? io : &nothing;
+    run->profile = profile;
 
-            case 'u':
-                B_SHOULD_OPTIMIZE_CODE = B_FALSE;
-                break;
+    run->input_cursor = run->io->input;
+    run->input_end = run->io->input + run->io->input_length;
 
-            case 'v':
-                printf("%s (brainfuck) %s (%s)\n", B_INVOCATION,
-                    B_VERSION_STRING, B_BUILD_FEATURES);
-                break;
+    run->step_limit = (limits->step_limit != 0)
+        ? limits->step_limit - handle->statistics.number_of_evaluated_opcodes
+        : UINT64_MAX;
+    run->generation = ++B_RUN_GENERATION;
+    run->is_deferring_timeout = B_TRUE;
 
-            case 'x':
-                B_SHOULD_INTERPRET_CODE = B_FALSE;
-                break;
+    B_RUN = run;
 
-            case 'z':
-                if (i + 1 >= count) {
-                    printf(
-                        "%s: the argument `z` requires "
-                        "a numerical parameter\n",
-                        B_INVOCATION);
-                    abort();
-                }
+    if (limits->time_limit > 0) {
+        status = start_timer(run, limits->time_limit);
+    }
 
-                B_CONTAINER_LENGTH = atoi(arguments[++i]);
+    if (status == B_SUCCESS) {
+        status = execute(handle, engine, run, statistics);
+    }
 
-                if (B_CONTAINER_LENGTH == 0) {
-                    printf(
-                        "%s: the tape length cannot be "
-                        "alphanumerical or zero\n",
-                        B_INVOCATION);
-                    abort();
-                }
+    if (run->has_timer == B_TRUE) {
+        timer_delete(run->timer);
+    }
 
-                break;
+    B_RUN = NULL;
 
-            default:
-                printf(
-                    "%s: unknown option `%c`\n", B_INVOCATION, arguments[i][1]);
-            }
+    tape->limit = 0;
+    shrink_tape(tape);
 
-            break;
+    if (run->tier != NULL) {
+        stop_tier(run->tier, statistics);
+    }
 
-        default:
-            if (B_INPUT_FILENAME != NULL) {
-                printf(
-                    "%s: warning, overriding previously "
-                    "specified filename\n",
-                    B_INVOCATION);
-            }
+    free(run->handlers);
+    free(run);
 
-            B_INPUT_FILENAME = arguments[i];
-        }
-    }
+    return status;
 }
 
-void respond_to_signal(int signal_identifier)
+enum brainfuck_status brainfuck_run(struct brainfuck_program const *program,
+    enum brainfuck_engine engine, struct brainfuck_tape *tape,
+    struct brainfuck_io const *io, struct brainfuck_limits const *limits,
+    struct brainfuck_run_statistics *statistics)
 {
-    (void) signal_identifier;
+    if (program == NULL) {
+        abort();
+    }
 
-    printf("%s: aborting\n", B_INVOCATION);
-    exit(EXIT_FAILURE);
+    return run_program(program, engine, NULL, tape, io, limits, statistics);
 }
 
-int main(int count, char **arguments)
+enum brainfuck_status brainfuck_profile(struct brainfuck_program const *program,
+    struct brainfuck_tape *tape, struct brainfuck_io const *io,
+    struct brainfuck_limits const *limits, FILE *report)
 {
-    char *source_code = NULL;
-    struct program *program = NULL;
+    struct profile profile;
+    size_t length = 0;
 
-    signal(SIGABRT, respond_to_signal);
-    signal(SIGINT, respond_to_signal);
+    enum brainfuck_status status = B_OUT_OF_MEMORY;
 
-    B_INVOCATION = arguments[0];
-
-    if (count == 1) {
-        printf("%s: no input files\n", B_INVOCATION);
+    if (program == NULL || report == NULL) {
         abort();
     }
 
-    parse_command_line(count, arguments);
+    length = sizeof(uint64_t) * program->program->number_of_opcodes;
 
-    if (B_SHOULD_READ_FROM_STDIN == B_TRUE || B_INPUT_FILENAME == NULL) {
-        source_code = read_stdin();
-    } else {
-        source_code = read_file(B_INPUT_FILENAME);
-    }
+    profile.executions = calloc(1, length);
+    profile.successions = calloc(1, length);
+    profile.iterations = calloc(1, length);
+    profile.ticks = calloc(1, length);
+    profile.started = calloc(1, length);
+    profile.total = 0;
 
-    source_code = sanitize(&source_code);
+    if (profile.executions != NULL && profile.successions != NULL &&
+        profile.iterations != NULL && profile.ticks != NULL &&
+        profile.started != NULL) {
+        status = run_program(
+            program, B_SWITCH_ENGINE, &profile, tape, io, limits, NULL);
+    }
 
-    if (B_SHOULD_OPTIMIZE_CODE == B_TRUE) {
-        program = run_length_encode(source_code);
+    if (status == B_SUCCESS) {
+        status = report_profile(program->program, &profile, report);
     }
 
-    program = link_branches(program);
+    free(profile.started);
+    free(profile.ticks);
+    free(profile.iterations);
+    free(profile.successions);
+    free(profile.executions);
 
-    if (B_SHOULD_PRINT_BYTECODE_DISASSEMBLY == B_TRUE) {
-        disassamble(program);
-    }
+    return status;
+}
 
-    if (B_SHOULD_EXPLAIN_CODE == B_TRUE) {
-        explain(program);
+void brainfuck_disassemble(struct brainfuck_program const *program, FILE *file)
+{
+    if (program == NULL) {
+        abort();
     }
 
-    if (B_SHOULD_EMIT_C_CODE == B_TRUE) {
-        emit_c_code(program, B_C_CODE_FILENAME);
-    }
+    disassamble(program->bytecode, file);
+}
 
-    if (B_SHOULD_EMIT_LLVM_IR == B_TRUE) {
-        emit_llvm_ir(program, B_LLVM_IR_FILENAME);
+void brainfuck_explain(struct brainfuck_program const *program, FILE *file)
+{
+    if (program == NULL) {
+        abort();
     }
 
-    if (B_SHOULD_COMPILE_AND_EXECUTE == B_TRUE) {
-        execute(program);
+    explain(program->bytecode, file);
+}
+
+enum brainfuck_status brainfuck_emit_c_code(
+    struct brainfuck_program const *program, char const *filename)
+{
+    if (program == NULL || filename == NULL) {
+        abort();
     }
 
-    if (B_SHOULD_INTERPRET_CODE == B_TRUE) {
-        interpret(program);
+    return emit_c_code(program->program, filename);
+}
+
+enum brainfuck_status brainfuck_emit_llvm_ir(
+    struct brainfuck_program const *program, char const *filename)
+{
+    if (program == NULL || filename == NULL) {
+        abort();
     }
 
-    free_program(program);
-    free(source_code);
+    return emit_llvm_ir(program->program, filename);
+}
 
-    return 0;
+enum brainfuck_status brainfuck_emit_executable(
+    struct brainfuck_program const *program, char const *filename)
+{
+    if (program == NULL || filename == NULL) {
+        abort();
+    }
+
+    return emit_executable(program->program, filename);
 }
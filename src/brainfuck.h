@@ -0,0 +1,181 @@
+/* The library interface.  A program is compiled once into an immutable
+ * handle, which can then be run any number of times and from any number of
+ * threads at once, each run on a tape of its own and reading and writing
+ * through callbacks of its own.  Nothing in here prints or aborts on behalf of
+ * the caller: whatever can fail returns a status instead. */
+
+#ifndef B_BRAINFUCK_H
+#define B_BRAINFUCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <sys/types.h>
+
+#define B_VERSION_STRING "0.4"
+
+enum brainfuck_status {
+    B_SUCCESS = 0,
+    B_OUT_OF_MEMORY,
+    B_NOTHING_TO_DO,
+    B_UNMATCHED_BRACKET,
+    B_PROGRAM_TOO_LARGE,
+    B_CANNOT_READ,
+    B_CANNOT_WRITE,
+    B_TAPE_EXHAUSTED,
+    B_COMPILATION_FAILED,
+    B_UNSUPPORTED,
+    B_TIMED_OUT,
+    B_STEP_LIMIT_EXCEEDED
+};
+
+/* The compiled and assembled engines run code that is generated when the
+ * program is compiled, so they need `should_compile` and `should_assemble`
+ * respectively.  The others are always available. */
+enum brainfuck_engine {
+    B_SWITCH_ENGINE,
+    B_THREADED_ENGINE,
+    B_COMPACT_ENGINE,
+    B_TIERED_ENGINE,
+    B_COMPILED_ENGINE,
+    B_ASSEMBLED_ENGINE
+};
+
+struct brainfuck_options {
+    int cell_width;
+    int should_optimize;
+    int optimization_level;
+
+    int end_of_input_value;
+    int should_keep_cell_at_end_of_input;
+
+    int should_compile;
+    int should_assemble;
+    char const *cache_directory;
+
+    /* Checks the tape bounds wherever the pointer is not known to stay in
+     * them, so that no engine relies on the guard pages alone. */
+    int should_check_tape;
+
+    /* With `should_optimize`, the program is run for up to this many opcodes
+     * while it is compiled, as far as it gets without input, and only the
+     * rest of it is left to run.  Those opcodes still count against the
+     * step limit of every run.  Zero turns that off. */
+    uint64_t evaluation_budget;
+
+    /* Only for emitted C code and executables, which allocate their own
+     * tape. */
+    size_t container_length;
+    int should_use_huge_pages;
+};
+
+/* Input comes from `input` first and, once that runs out, from `read`, if
+ * there is one.  `read` returns how many bytes it stored, 0 at the end of
+ * the input or -1 on an error, and `write` returns 0 or -1. */
+struct brainfuck_io {
+    unsigned char const *input;
+    size_t input_length;
+
+    ssize_t (*read)(void *context, unsigned char *buffer, size_t length);
+    int (*write)(void *context, unsigned char const *buffer, size_t length);
+
+    void *context;
+};
+
+struct brainfuck_statistics {
+    size_t source_length;
+    size_t number_of_opcodes;
+    double loading_time;
+
+    size_t number_of_tape_checks;
+
+    uint64_t number_of_evaluated_opcodes;
+    size_t evaluated_output_length;
+    double evaluation_time;
+
+    double compilation_time;
+    double assembly_time;
+
+    int is_cached;
+    unsigned long long cache_hits;
+    unsigned long long cache_misses;
+};
+
+/* A run stops with `B_STEP_LIMIT_EXCEEDED` once it has executed more than
+ * `step_limit` opcodes, checked whenever a loop goes round, with
+ * `B_TIMED_OUT` after `time_limit` seconds, and with `B_TAPE_EXHAUSTED` once
+ * it needs more than `tape_limit` bytes of tape, counted in whole pages.  Zero
+ * means no limit.  Only the switch engine counts opcodes, so only it takes a
+ * step limit, and it counts those evaluated while compiling as well.
+ * Timeouts are delivered with SIGRTMIN to the thread doing the run. */
+struct brainfuck_limits {
+    uint64_t step_limit;
+    double time_limit;
+    size_t tape_limit;
+};
+
+/* Only the switch engine counts opcodes, and only the tiered engine
+ * compiles loops. */
+struct brainfuck_run_statistics {
+    uint64_t number_of_executed_opcodes;
+
+    size_t number_of_hot_loops;
+    size_t number_of_compiled_loops;
+    double compilation_time;
+};
+
+struct brainfuck_program;
+struct brainfuck_tape;
+
+void brainfuck_set_default_options(struct brainfuck_options *options);
+char const *brainfuck_describe_status(enum brainfuck_status status);
+
+/* On `B_UNMATCHED_BRACKET`, `position` (if not NULL) is set to the offset of
+ * the bracket in the source.  A NULL filename reads the program from
+ * stdin. */
+enum brainfuck_status brainfuck_compile(char const *source, size_t length,
+    struct brainfuck_options const *options,
+    struct brainfuck_program **program, size_t *position);
+enum brainfuck_status brainfuck_compile_file(char const *filename,
+    struct brainfuck_options const *options,
+    struct brainfuck_program **program, size_t *position);
+
+void brainfuck_get_statistics(struct brainfuck_program const *program,
+    struct brainfuck_statistics *statistics);
+void brainfuck_destroy_program(struct brainfuck_program *program);
+
+/* A tape commits `length` bytes up front and grows on demand from there.  A
+ * run clears whatever the previous one left on it, and only one run can use
+ * a tape at a time.  The tape grows from a SIGSEGV handler, which the first
+ * tape installs on an alternate stack for its own thread unless that thread
+ * has one already; other threads take tape faults on their own stacks. */
+enum brainfuck_status brainfuck_create_tape(size_t length,
+    int should_use_huge_pages, struct brainfuck_tape **tape);
+void brainfuck_destroy_tape(struct brainfuck_tape *tape);
+
+/* `limits` and `statistics` may be NULL. */
+enum brainfuck_status brainfuck_run(struct brainfuck_program const *program,
+    enum brainfuck_engine engine, struct brainfuck_tape *tape,
+    struct brainfuck_io const *io, struct brainfuck_limits const *limits,
+    struct brainfuck_run_statistics *statistics);
+
+/* Runs the program on the switch engine with every opcode counted and every
+ * loop timed, and writes a report of the hottest ones to `report`.  `limits`
+ * may be NULL. */
+enum brainfuck_status brainfuck_profile(struct brainfuck_program const *program,
+    struct brainfuck_tape *tape, struct brainfuck_io const *io,
+    struct brainfuck_limits const *limits, FILE *report);
+
+void brainfuck_disassemble(
+    struct brainfuck_program const *program, FILE *file);
+void brainfuck_explain(struct brainfuck_program const *program, FILE *file);
+
+enum brainfuck_status brainfuck_emit_c_code(
+    struct brainfuck_program const *program, char const *filename);
+enum brainfuck_status brainfuck_emit_llvm_ir(
+    struct brainfuck_program const *program, char const *filename);
+enum brainfuck_status brainfuck_emit_executable(
+    struct brainfuck_program const *program, char const *filename);
+
+#endif
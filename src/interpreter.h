@@ -0,0 +1,827 @@
+/* The scan kernels and the interpreters, written once against a cell type.
+ * brainfuck.c includes this file once per cell width, each time with `B_CELL`
+ * defined as the cell type and `B_INSTANCE(name)` giving the name of the
+ * instance, so the width is settled at compile time in every one of them. */
+
+#define B_LANES (B_VECTOR_WIDTH / sizeof(B_CELL))
+
+/* The threaded and compact interpreters each define the parts, `B_NEXT()`
+ * to step to the second opcode of a pair and the handler macros, and then
+ * get the same superinstructions out of these. */
+#define B_SUPERINSTRUCTION(code, first, second)                             \
+    B_HANDLER(code)                                                         \
+        first();                                                            \
+        B_NEXT();                                                           \
+        second();                                                           \
+        B_DISPATCH();
+
+#define B_SUPERINSTRUCTIONS()                                               \
+    B_SUPERINSTRUCTION(B_MULTIPLY_MULTIPLY, B_MULTIPLY, B_MULTIPLY)         \
+    B_SUPERINSTRUCTION(B_MULTIPLY_SET, B_MULTIPLY, B_SET)                   \
+    B_SUPERINSTRUCTION(B_SET_MULTIPLY, B_SET, B_MULTIPLY)                   \
+    B_SUPERINSTRUCTION(B_SET_SET, B_SET, B_SET)                             \
+    B_SUPERINSTRUCTION(B_SET_DECREMENT, B_SET, B_DECREMENT)                 \
+    B_SUPERINSTRUCTION(B_SET_MOVE_LEFT, B_SET, B_MOVE_LEFT)                 \
+    B_SUPERINSTRUCTION(B_SET_MOVE_RIGHT, B_SET, B_MOVE_RIGHT)               \
+    B_SUPERINSTRUCTION(B_SET_BRANCH_BACKWARD, B_SET, B_BRANCH_BACK)         \
+    B_SUPERINSTRUCTION(                                                     \
+        B_DECREMENT_BRANCH_BACKWARD, B_DECREMENT, B_BRANCH_BACK)            \
+    B_SUPERINSTRUCTION(                                                     \
+        B_MOVE_LEFT_BRANCH_BACKWARD, B_MOVE_LEFT, B_BRANCH_BACK)            \
+    B_SUPERINSTRUCTION(                                                     \
+        B_MOVE_RIGHT_BRANCH_BACKWARD, B_MOVE_RIGHT, B_BRANCH_BACK)          \
+    B_SUPERINSTRUCTION(B_MOVE_RIGHT_BRANCH_FORWARD, B_MOVE_RIGHT, B_BRANCH)
+
+#define B_REGISTER_SUPERINSTRUCTIONS()                                      \
+    B_REGISTER_SUPERINSTRUCTION(B_MULTIPLY_MULTIPLY);                       \
+    B_REGISTER_SUPERINSTRUCTION(B_MULTIPLY_SET);                            \
+    B_REGISTER_SUPERINSTRUCTION(B_SET_MULTIPLY);                            \
+    B_REGISTER_SUPERINSTRUCTION(B_SET_SET);                                 \
+    B_REGISTER_SUPERINSTRUCTION(B_SET_DECREMENT);                           \
+    B_REGISTER_SUPERINSTRUCTION(B_SET_MOVE_LEFT);                           \
+    B_REGISTER_SUPERINSTRUCTION(B_SET_MOVE_RIGHT);                          \
+    B_REGISTER_SUPERINSTRUCTION(B_SET_BRANCH_BACKWARD);                     \
+    B_REGISTER_SUPERINSTRUCTION(B_DECREMENT_BRANCH_BACKWARD);               \
+    B_REGISTER_SUPERINSTRUCTION(B_MOVE_LEFT_BRANCH_BACKWARD);               \
+    B_REGISTER_SUPERINSTRUCTION(B_MOVE_RIGHT_BRANCH_BACKWARD);              \
+    B_REGISTER_SUPERINSTRUCTION(B_MOVE_RIGHT_BRANCH_FORWARD)
+
+#if defined(__SSE2__) && defined(__GNUC__)
+/* One bit per byte of the vector, set across every cell that is zero.  SSE2
+ * has no 64-bit compare, so both halves of a 64-bit cell have to be zero. */
+static inline unsigned int B_INSTANCE(get_zero_mask)(B_CELL const *pointer)
+{
+    __m128i cells = _mm_loadu_si128((__m128i const *) pointer);
+    __m128i zeros = _mm_setzero_si128();
+
+    if (sizeof(B_CELL) == 1) {
+        zeros = _mm_cmpeq_epi8(cells, zeros);
+    } else if (sizeof(B_CELL) == 2) {
+        zeros = _mm_cmpeq_epi16(cells, zeros);
+    } else if (sizeof(B_CELL) == 4) {
+        zeros = _mm_cmpeq_epi32(cells, zeros);
+    } else {
+        zeros = _mm_cmpeq_epi32(cells, zeros);
+        zeros = _mm_and_si128(
+            zeros, _mm_shuffle_epi32(zeros, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+
+    return _mm_movemask_epi8(zeros);
+}
+#endif
+
+/* Both scan kernels only vectorize within the tape, then finish with a plain
+ * loop so that a scan that runs off the tape behaves just like the loop it
+ * replaced. */
+static B_CELL *B_INSTANCE(scan_right)(B_CELL *pointer, size_t stride)
+{
+    B_CELL const *end = (B_CELL const *) B_RUN->tape->end;
+
+    if (sizeof(B_CELL) == 1 && stride == 1 && pointer < end) {
+        B_CELL *cell = memchr(pointer, 0, end - pointer);
+
+        if (cell != NULL) {
+            return cell;
+        }
+    }
+
+#if defined(__SSE2__) && defined(__GNUC__)
+    if (stride <= B_LANES) {
+        size_t step = B_LANES - B_LANES % stride;
+        unsigned int mask = get_stride_mask(stride, sizeof(B_CELL), B_FALSE);
+
+        while (pointer < end && (size_t) (end - pointer) >= B_LANES) {
+            unsigned int zeros = mask & B_INSTANCE(get_zero_mask)(pointer);
+
+            if (zeros != 0) {
+                return pointer + __builtin_ctz(zeros) / sizeof(B_CELL);
+            }
+
+            pointer += step;
+        }
+    }
+#endif
+
+    while (*pointer != 0) {
+        pointer += stride;
+    }
+
+    return pointer;
+}
+
+static B_CELL *B_INSTANCE(scan_left)(B_CELL *pointer, size_t stride)
+{
+    B_CELL const *begin = (B_CELL const *) B_RUN->tape->begin;
+
+#if defined(__GLIBC__)
+    if (sizeof(B_CELL) == 1 && stride == 1 && pointer >= begin) {
+        B_CELL *cell = memrchr(begin, 0, pointer - begin + 1);
+
+        if (cell != NULL) {
+            return cell;
+        }
+    }
+#endif
+
+#if defined(__SSE2__) && defined(__GNUC__)
+    if (stride <= B_LANES) {
+        size_t step = B_LANES - B_LANES % stride;
+        unsigned int mask = get_stride_mask(stride, sizeof(B_CELL), B_TRUE);
+
+        while (pointer >= begin && (size_t) (pointer - begin) >= B_LANES - 1) {
+            unsigned int zeros = mask &
+                B_INSTANCE(get_zero_mask)(pointer - (B_LANES - 1));
+
+            if (zeros != 0) {
+                return pointer - (__builtin_clz(zeros) - 16) / sizeof(B_CELL);
+            }
+
+            pointer -= step;
+        }
+    }
+#endif
+
+    while (*pointer != 0) {
+        pointer -= stride;
+    }
+
+    return pointer;
+}
+
+/* With a tier, loops are counted at both of their branches and a compiled
+ * one takes over from its header until the loop exits.  Either way it returns
+ * how many opcodes ran, as a yardstick for the other engines, and stops the
+ * run once a loop goes round with more than `limit` of them behind it.  With
+ * a profile, every opcode and loop iteration is counted, along with every
+ * opcode that ran straight after the one before it, and each loop is timed
+ * from its entry to its exit. */
+static B_ALWAYS_INLINE uint64_t B_INSTANCE(interpret_switch)(
+    struct program const *program, struct tier *tier, struct profile *profile,
+    uint64_t limit, char *tape)
+{
+    size_t i = 0;
+    size_t previous = 0;
+
+    B_CELL *container = (B_CELL *) tape;
+    B_CELL *pointer = container;
+
+    compiled_loop loop = NULL;
+    uint64_t executed = 0;
+
+    if (program == NULL || program->opcodes == NULL) {
+        abort();
+    }
+
+    for (; i != program->number_of_opcodes; ++i, ++executed) {
+        if (profile != NULL) {
+            ++profile->executions[i];
+
+            if (executed != 0 && i == previous + 1) {
+                ++profile->successions[previous];
+            }
+
+            previous = i;
+        }
+
+        switch (program->opcodes[i].instruction) {
+        case B_MOVE_POINTER_LEFT:
+            pointer -= program->opcodes[i].auxiliary;
+            break;
+
+        case B_MOVE_POINTER_RIGHT:
+            pointer += program->opcodes[i].auxiliary;
+            break;
+
+        case B_INCREMENT_CELL_VALUE:
+            pointer[program->opcodes[i].offset] += program->opcodes[i].auxiliary;
+            break;
+
+        case B_DECREMENT_CELL_VALUE:
+            pointer[program->opcodes[i].offset] -= program->opcodes[i].auxiliary;
+            break;
+
+        case B_OUTPUT_CELL_VALUE:
+            write_output((unsigned char) pointer[program->opcodes[i].offset],
+                program->opcodes[i].auxiliary);
+            break;
+
+        case B_INPUT_CELL_VALUE:
+            pointer[program->opcodes[i].offset] =
+                read_input(pointer[program->opcodes[i].offset]);
+            break;
+
+        case B_BRANCH_FORWARD:
+            if (*pointer == 0) {
+                i = program->opcodes[i].auxiliary;
+            } else if (tier != NULL && (loop = find_compiled_loop(tier, i))) {
+                pointer = container + loop(container, pointer - container);
+                i = program->opcodes[i].auxiliary;
+            } else if (profile != NULL) {
+                ++profile->iterations[i];
+                profile->started[i] = read_timestamp();
+            }
+
+            break;
+
+        case B_BRANCH_BACKWARD:
+            if (*pointer != 0) {
+                if (executed >= limit) {
+                    siglongjmp(B_RUN->exit, B_STEP_LIMIT_EXCEEDED);
+                }
+
+                i = program->opcodes[i].auxiliary;
+
+                if (tier != NULL && (loop = find_compiled_loop(tier, i))) {
+                    pointer = container + loop(container, pointer - container);
+                    i = program->opcodes[i].auxiliary;
+                } else if (profile != NULL) {
+                    ++profile->iterations[i];
+                }
+            } else if (profile != NULL) {
+                size_t header = program->opcodes[i].auxiliary;
+
+                profile->ticks[header] +=
+                    read_timestamp() - profile->started[header];
+            }
+
+            break;
+
+        case B_SET_CELL_VALUE:
+            pointer[program->opcodes[i].offset] = program->opcodes[i].auxiliary;
+            break;
+
+        case B_MULTIPLY_CELL_VALUE:
+            pointer[program->opcodes[i].offset] +=
+                pointer[program->opcodes[i].source] *
+                program->opcodes[i].auxiliary;
+            break;
+
+        case B_SCAN_LEFT:
+            pointer = B_INSTANCE(scan_left)(
+                pointer, program->opcodes[i].auxiliary);
+            break;
+
+        case B_SCAN_RIGHT:
+            pointer = B_INSTANCE(scan_right)(
+                pointer, program->opcodes[i].auxiliary);
+            break;
+
+        case B_CHECK_TAPE:
+            check_tape((char const *) (pointer + program->opcodes[i].offset),
+                (char const *) (pointer + program->opcodes[i].source));
+            break;
+
+        case B_OUTPUT_CONSTANT:
+            write_constant(program->constants + program->opcodes[i].offset,
+                program->opcodes[i].auxiliary);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return executed;
+}
+
+static uint64_t B_INSTANCE(interpret)(struct program const *program,
+    struct tier *tier, uint64_t limit, char *tape)
+{
+    return B_INSTANCE(interpret_switch)(program, tier, NULL, limit, tape);
+}
+
+/* A copy of its own, so that the profiling costs nothing when it is off. */
+static void B_INSTANCE(interpret_profiled)(struct program const *program,
+    struct profile *profile, uint64_t limit, char *tape)
+{
+    uint64_t start = read_timestamp();
+
+    B_INSTANCE(interpret_switch)(program, NULL, profile, limit, tape);
+    profile->total = read_timestamp() - start;
+}
+
+/* The same interpreter, threaded: every opcode is resolved to the address of
+ * its handler up front and each handler dispatches straight to the next one,
+ * so there is neither a shared indirect branch nor a bounds check.  Compilers
+ * without labels as values get a switch that relies on `B_TERMINATE` alone to
+ * stop. */
+#if defined(__GNUC__)
+#define B_HANDLER(instruction) handle_##instruction:
+#define B_DISPATCH() goto *handlers[++i]
+#define B_REGISTER_SUPERINSTRUCTION(code)                                   \
+    superinstructions[code] = &&handle_##code
+#else
+#define B_HANDLER(instruction) case instruction:
+#define B_DISPATCH() ++i; continue
+#endif
+
+/* A pair runs from the handler of its first opcode.  The second keeps a
+ * handler of its own, for when a branch lands on it. */
+#define B_NEXT() ++i
+#define B_MOVE_LEFT() pointer -= opcodes[i].auxiliary
+#define B_MOVE_RIGHT() pointer += opcodes[i].auxiliary
+#define B_DECREMENT() pointer[opcodes[i].offset] -= opcodes[i].auxiliary
+#define B_SET() pointer[opcodes[i].offset] = opcodes[i].auxiliary
+#define B_MULTIPLY()                                                        \
+    pointer[opcodes[i].offset] +=                                           \
+        pointer[opcodes[i].source] * opcodes[i].auxiliary
+#define B_BRANCH()                                                          \
+    if (*pointer == 0) {                                                    \
+        i = opcodes[i].auxiliary;                                           \
+    }
+#define B_BRANCH_BACK()                                                     \
+    if (*pointer != 0) {                                                    \
+        i = opcodes[i].auxiliary;                                           \
+    }
+
+/* `handlers` has room for one address per opcode.  It is the caller's, so
+ * that a run that is cut short does not leak it. */
+static void B_INSTANCE(interpret_threaded)(
+    struct program const *program, char *tape, void **handlers)
+{
+    size_t i = 0;
+
+    struct opcode const *opcodes = NULL;
+    B_CELL *pointer = (B_CELL *) tape;
+
+#if defined(__GNUC__)
+    void *superinstructions[B_NUMBER_OF_SUPERINSTRUCTIONS];
+    unsigned int code = 0;
+#endif
+
+    if (program == NULL || program->opcodes == NULL || handlers == NULL) {
+        abort();
+    }
+
+    opcodes = program->opcodes;
+
+#if defined(__GNUC__)
+    B_REGISTER_SUPERINSTRUCTIONS();
+
+    for (; i != program->number_of_opcodes; ++i) {
+        switch (opcodes[i].instruction) {
+        case B_MOVE_POINTER_LEFT:
+            handlers[i] = &&handle_B_MOVE_POINTER_LEFT;
+            break;
+
+        case B_MOVE_POINTER_RIGHT:
+            handlers[i] = &&handle_B_MOVE_POINTER_RIGHT;
+            break;
+
+        case B_INCREMENT_CELL_VALUE:
+            handlers[i] = &&handle_B_INCREMENT_CELL_VALUE;
+            break;
+
+        case B_DECREMENT_CELL_VALUE:
+            handlers[i] = &&handle_B_DECREMENT_CELL_VALUE;
+            break;
+
+        case B_OUTPUT_CELL_VALUE:
+            handlers[i] = &&handle_B_OUTPUT_CELL_VALUE;
+            break;
+
+        case B_INPUT_CELL_VALUE:
+            handlers[i] = &&handle_B_INPUT_CELL_VALUE;
+            break;
+
+        case B_BRANCH_FORWARD:
+            handlers[i] = &&handle_B_BRANCH_FORWARD;
+            break;
+
+        case B_BRANCH_BACKWARD:
+            handlers[i] = &&handle_B_BRANCH_BACKWARD;
+            break;
+
+        case B_SET_CELL_VALUE:
+            handlers[i] = &&handle_B_SET_CELL_VALUE;
+            break;
+
+        case B_MULTIPLY_CELL_VALUE:
+            handlers[i] = &&handle_B_MULTIPLY_CELL_VALUE;
+            break;
+
+        case B_SCAN_LEFT:
+            handlers[i] = &&handle_B_SCAN_LEFT;
+            break;
+
+        case B_SCAN_RIGHT:
+            handlers[i] = &&handle_B_SCAN_RIGHT;
+            break;
+
+        case B_CHECK_TAPE:
+            handlers[i] = &&handle_B_CHECK_TAPE;
+            break;
+
+        case B_OUTPUT_CONSTANT:
+            handlers[i] = &&handle_B_OUTPUT_CONSTANT;
+            break;
+
+        case B_TERMINATE:
+            handlers[i] = &&handle_B_TERMINATE;
+            break;
+
+        default:
+            handlers[i] = &&handle_B_INVALID;
+            break;
+        }
+
+        if (program->options.should_optimize == B_TRUE &&
+            i + 1 != program->number_of_opcodes &&
+            (code = find_superinstruction(
+                 opcodes[i].instruction, opcodes[i + 1].instruction)) != 0) {
+            handlers[i] = superinstructions[code];
+        }
+    }
+
+    i = 0;
+    goto *handlers[0];
+#else
+    for (;;) {
+        switch (opcodes[i].instruction) {
+#endif
+
+    B_HANDLER(B_MOVE_POINTER_LEFT)
+        pointer -= opcodes[i].auxiliary;
+        B_DISPATCH();
+
+    B_HANDLER(B_MOVE_POINTER_RIGHT)
+        pointer += opcodes[i].auxiliary;
+        B_DISPATCH();
+
+    B_HANDLER(B_INCREMENT_CELL_VALUE)
+        pointer[opcodes[i].offset] += opcodes[i].auxiliary;
+        B_DISPATCH();
+
+    B_HANDLER(B_DECREMENT_CELL_VALUE)
+        pointer[opcodes[i].offset] -= opcodes[i].auxiliary;
+        B_DISPATCH();
+
+    B_HANDLER(B_OUTPUT_CELL_VALUE)
+        write_output(
+            (unsigned char) pointer[opcodes[i].offset], opcodes[i].auxiliary);
+        B_DISPATCH();
+
+    B_HANDLER(B_INPUT_CELL_VALUE)
+        pointer[opcodes[i].offset] = read_input(pointer[opcodes[i].offset]);
+        B_DISPATCH();
+
+    B_HANDLER(B_BRANCH_FORWARD)
+        if (*pointer == 0) {
+            i = opcodes[i].auxiliary;
+        }
+
+        B_DISPATCH();
+
+    B_HANDLER(B_BRANCH_BACKWARD)
+        if (*pointer != 0) {
+            i = opcodes[i].auxiliary;
+        }
+
+        B_DISPATCH();
+
+    B_HANDLER(B_SET_CELL_VALUE)
+        pointer[opcodes[i].offset] = opcodes[i].auxiliary;
+        B_DISPATCH();
+
+    B_HANDLER(B_MULTIPLY_CELL_VALUE)
+        pointer[opcodes[i].offset] +=
+            pointer[opcodes[i].source] * opcodes[i].auxiliary;
+        B_DISPATCH();
+
+    B_HANDLER(B_SCAN_LEFT)
+        pointer = B_INSTANCE(scan_left)(pointer, opcodes[i].auxiliary);
+        B_DISPATCH();
+
+    B_HANDLER(B_SCAN_RIGHT)
+        pointer = B_INSTANCE(scan_right)(pointer, opcodes[i].auxiliary);
+        B_DISPATCH();
+
+    B_HANDLER(B_CHECK_TAPE)
+        check_tape((char const *) (pointer + opcodes[i].offset),
+            (char const *) (pointer + opcodes[i].source));
+        B_DISPATCH();
+
+    B_HANDLER(B_OUTPUT_CONSTANT)
+        write_constant(
+            program->constants + opcodes[i].offset, opcodes[i].auxiliary);
+        B_DISPATCH();
+
+#if defined(__GNUC__)
+    B_SUPERINSTRUCTIONS()
+#endif
+
+    B_HANDLER(B_INVALID)
+        B_DISPATCH();
+
+#if !defined(__GNUC__)
+        default:
+            B_DISPATCH();
+
+        B_HANDLER(B_TERMINATE)
+            break;
+        }
+
+        break;
+    }
+#else
+    B_HANDLER(B_TERMINATE)
+#endif
+
+    (void) handlers;
+}
+
+#undef B_BRANCH_BACK
+#undef B_BRANCH
+#undef B_MULTIPLY
+#undef B_SET
+#undef B_DECREMENT
+#undef B_MOVE_RIGHT
+#undef B_MOVE_LEFT
+#undef B_NEXT
+#undef B_REGISTER_SUPERINSTRUCTION
+#undef B_DISPATCH
+#undef B_HANDLER
+
+/* Runs straight from the packed words: the instruction byte of each word
+ * selects the handler, and wide opcodes have handlers of their own that read
+ * the side table. */
+#if defined(__GNUC__)
+#define B_HANDLER(instruction) handle_##instruction:
+#define B_WIDE_HANDLER(instruction) handle_wide_##instruction:
+#define B_DISPATCH()                                                        \
+    word = words[++i];                                                      \
+    goto *handlers[word & 0xFF]
+#define B_REGISTER(instruction)                                             \
+    handlers[instruction] = &&handle_##instruction;                         \
+    handlers[instruction | B_WIDE_OPCODE] = &&handle_wide_##instruction
+#define B_REGISTER_SUPERINSTRUCTION(code) handlers[code] = &&handle_##code
+#else
+#define B_HANDLER(instruction) case instruction:
+#define B_WIDE_HANDLER(instruction) case instruction | B_WIDE_OPCODE:
+#define B_DISPATCH()                                                        \
+    ++i;                                                                    \
+    continue
+#endif
+
+/* The parts of the superinstructions, on the word at hand.  Only compact
+ * words are ever paired. */
+#define B_NEXT() word = words[++i]
+#define B_MOVE_LEFT() pointer -= word >> 8
+#define B_MOVE_RIGHT() pointer += word >> 8
+#define B_DECREMENT()                                                       \
+    pointer[(int16_t) (word >> 16)] -= (unsigned char) (word >> 8)
+#define B_SET() pointer[(int16_t) (word >> 16)] = (uint8_t) (word >> 8)
+#define B_MULTIPLY()                                                        \
+    pointer[(int8_t) (word >> 16)] +=                                       \
+        pointer[(int8_t) (word >> 24)] * (unsigned char) (word >> 8)
+#define B_BRANCH()                                                          \
+    if (*pointer == 0) {                                                    \
+        i = word >> 8;                                                      \
+    }
+#define B_BRANCH_BACK()                                                     \
+    if (*pointer != 0) {                                                    \
+        i = word >> 8;                                                      \
+    }
+
+static void B_INSTANCE(interpret_compact)(
+    struct bytecode const *bytecode, char *tape)
+{
+    size_t i = 0;
+
+    uint32_t const *words = NULL;
+    uint32_t word = 0;
+
+    struct opcode const *operand = NULL;
+    B_CELL *pointer = (B_CELL *) tape;
+
+#if defined(__GNUC__)
+    void *handlers[256];
+#endif
+
+    if (bytecode == NULL || bytecode->words == NULL) {
+        abort();
+    }
+
+    words = bytecode->words;
+
+#if defined(__GNUC__)
+    for (; i != 256; ++i) {
+        handlers[i] = &&handle_B_INVALID;
+    }
+
+    B_REGISTER(B_MOVE_POINTER_LEFT);
+    B_REGISTER(B_MOVE_POINTER_RIGHT);
+    B_REGISTER(B_INCREMENT_CELL_VALUE);
+    B_REGISTER(B_DECREMENT_CELL_VALUE);
+    B_REGISTER(B_OUTPUT_CELL_VALUE);
+    B_REGISTER(B_INPUT_CELL_VALUE);
+    B_REGISTER(B_BRANCH_FORWARD);
+    B_REGISTER(B_BRANCH_BACKWARD);
+    B_REGISTER(B_SET_CELL_VALUE);
+    B_REGISTER(B_MULTIPLY_CELL_VALUE);
+    B_REGISTER(B_SCAN_LEFT);
+    B_REGISTER(B_SCAN_RIGHT);
+    B_REGISTER(B_CHECK_TAPE);
+
+    /* Constant output has no narrow form. */
+    handlers[B_OUTPUT_CONSTANT | B_WIDE_OPCODE] =
+        &&handle_wide_B_OUTPUT_CONSTANT;
+
+    B_REGISTER_SUPERINSTRUCTIONS();
+
+    handlers[B_TERMINATE] = &&handle_B_TERMINATE;
+
+    i = 0;
+    word = words[0];
+
+    goto *handlers[word & 0xFF];
+#else
+    for (;;) {
+        word = words[i];
+        operand = bytecode->operands + (word >> 8);
+
+        switch (word & 0xFF) {
+#endif
+
+    B_HANDLER(B_MOVE_POINTER_LEFT)
+        pointer -= word >> 8;
+        B_DISPATCH();
+
+    B_HANDLER(B_MOVE_POINTER_RIGHT)
+        pointer += word >> 8;
+        B_DISPATCH();
+
+    B_HANDLER(B_INCREMENT_CELL_VALUE)
+        pointer[(int16_t) (word >> 16)] += (unsigned char) (word >> 8);
+        B_DISPATCH();
+
+    B_HANDLER(B_DECREMENT_CELL_VALUE)
+        pointer[(int16_t) (word >> 16)] -= (unsigned char) (word >> 8);
+        B_DISPATCH();
+
+    B_HANDLER(B_OUTPUT_CELL_VALUE)
+        write_output((unsigned char) pointer[(int16_t) (word >> 16)],
+            (word >> 8) & 0xFF);
+        B_DISPATCH();
+
+    B_HANDLER(B_INPUT_CELL_VALUE)
+        pointer[(int16_t) (word >> 16)] =
+            read_input(pointer[(int16_t) (word >> 16)]);
+        B_DISPATCH();
+
+    B_HANDLER(B_BRANCH_FORWARD)
+        if (*pointer == 0) {
+            i = word >> 8;
+        }
+
+        B_DISPATCH();
+
+    B_HANDLER(B_BRANCH_BACKWARD)
+        if (*pointer != 0) {
+            i = word >> 8;
+        }
+
+        B_DISPATCH();
+
+    B_HANDLER(B_SET_CELL_VALUE)
+        pointer[(int16_t) (word >> 16)] = (uint8_t) (word >> 8);
+        B_DISPATCH();
+
+    B_HANDLER(B_MULTIPLY_CELL_VALUE)
+        pointer[(int8_t) (word >> 16)] +=
+            pointer[(int8_t) (word >> 24)] * (unsigned char) (word >> 8);
+        B_DISPATCH();
+
+    B_HANDLER(B_SCAN_LEFT)
+        pointer = B_INSTANCE(scan_left)(pointer, word >> 8);
+        B_DISPATCH();
+
+    B_HANDLER(B_SCAN_RIGHT)
+        pointer = B_INSTANCE(scan_right)(pointer, word >> 8);
+        B_DISPATCH();
+
+    B_HANDLER(B_CHECK_TAPE)
+        check_tape((char const *) (pointer + (int8_t) (word >> 16)),
+            (char const *) (pointer + (int8_t) (word >> 24)));
+        B_DISPATCH();
+
+#if defined(__GNUC__)
+#define B_OPERAND() (operand = bytecode->operands + (word >> 8))
+#else
+#define B_OPERAND() operand
+#endif
+
+    B_WIDE_HANDLER(B_MOVE_POINTER_LEFT)
+        pointer -= B_OPERAND()->auxiliary;
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_MOVE_POINTER_RIGHT)
+        pointer += B_OPERAND()->auxiliary;
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_INCREMENT_CELL_VALUE)
+        B_OPERAND();
+        pointer[operand->offset] += operand->auxiliary;
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_DECREMENT_CELL_VALUE)
+        B_OPERAND();
+        pointer[operand->offset] -= operand->auxiliary;
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_OUTPUT_CELL_VALUE)
+        B_OPERAND();
+        write_output(
+            (unsigned char) pointer[operand->offset], operand->auxiliary);
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_INPUT_CELL_VALUE)
+        B_OPERAND();
+        pointer[operand->offset] = read_input(pointer[operand->offset]);
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_BRANCH_FORWARD)
+        if (*pointer == 0) {
+            i = B_OPERAND()->auxiliary;
+        }
+
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_BRANCH_BACKWARD)
+        if (*pointer != 0) {
+            i = B_OPERAND()->auxiliary;
+        }
+
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_SET_CELL_VALUE)
+        B_OPERAND();
+        pointer[operand->offset] = operand->auxiliary;
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_MULTIPLY_CELL_VALUE)
+        B_OPERAND();
+        pointer[operand->offset] += pointer[operand->source] * operand->auxiliary;
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_SCAN_LEFT)
+        pointer = B_INSTANCE(scan_left)(pointer, B_OPERAND()->auxiliary);
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_SCAN_RIGHT)
+        pointer = B_INSTANCE(scan_right)(pointer, B_OPERAND()->auxiliary);
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_CHECK_TAPE)
+        B_OPERAND();
+        check_tape((char const *) (pointer + operand->offset),
+            (char const *) (pointer + operand->source));
+        B_DISPATCH();
+
+    B_WIDE_HANDLER(B_OUTPUT_CONSTANT)
+        B_OPERAND();
+        write_constant(
+            bytecode->constants + operand->offset, operand->auxiliary);
+        B_DISPATCH();
+
+    B_SUPERINSTRUCTIONS()
+
+    B_HANDLER(B_INVALID)
+        B_DISPATCH();
+
+#if !defined(__GNUC__)
+        default:
+            B_DISPATCH();
+
+        B_HANDLER(B_TERMINATE)
+            break;
+        }
+
+        break;
+    }
+#else
+    B_HANDLER(B_TERMINATE)
+#endif
+
+    return;
+}
+
+#undef B_BRANCH_BACK
+#undef B_BRANCH
+#undef B_MULTIPLY
+#undef B_SET
+#undef B_DECREMENT
+#undef B_MOVE_RIGHT
+#undef B_MOVE_LEFT
+#undef B_NEXT
+#undef B_OPERAND
+#undef B_REGISTER_SUPERINSTRUCTION
+#undef B_REGISTER
+#undef B_DISPATCH
+#undef B_WIDE_HANDLER
+#undef B_HANDLER
+
+#undef B_REGISTER_SUPERINSTRUCTIONS
+#undef B_SUPERINSTRUCTIONS
+#undef B_SUPERINSTRUCTION
+#undef B_LANES
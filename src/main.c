@@ -0,0 +1,892 @@
+/*
+ *  dP                         oo          .8888b                   dP
+ *  88                                     88   "                   88
+ *  88d888b. 88d888b. .d8888b. dP 88d888b. 88aaa  dP    dP .d8888b. 88  .dP
+ *  88'  `88 88'  `88 88'  `88 88 88'  `88 88     88    88 88'  `"" 88888"
+ *  88.  .88 88       88.  .88 88 88    88 88     88.  .88 88.  ... 88  `8b.
+ *  88Y8888' dP       `88888P8 dP dP    dP dP     `88888P' `88888P' dP   `YP
+ *
+ * Authored in 2013.  See README for a list of contributors.
+ * Released into the public domain.
+ *
+ * Any being (not just humans) is free to copy, modify, publish, use, compile,
+ * sell or distribute this software, either in source code form or as a
+ * compiled binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain.  We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors.  We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * The software is provided AS IS, without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose and non-infringement.  In no event shall
+ * the authors be liable for any claim, damages or other liability, whether in
+ * an action of contract, tort or otherwise, arising from, out of or in
+ * connection with the software or the use or other dealings in the software.
+ *
+ * This software is completely unlicensed. */
+
+/* The command line, a thin layer over the library in `brainfuck.h`.  It maps
+ * its flags onto the options, compiles the program once and then hands it to
+ * every engine that was asked for, one after the other, on the same tape. */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "brainfuck.h"
+
+#define B_BUILD_FEATURES "core:llvm-ir:bin"
+
+#define B_TRUE 1
+#define B_FALSE 0
+
+static char *B_INVOCATION = NULL;
+
+static struct brainfuck_options B_OPTIONS;
+static struct brainfuck_limits B_LIMITS = {0, 0.0, 0};
+static enum brainfuck_engine B_ENGINE = B_COMPACT_ENGINE;
+static int B_HAS_ENGINE = B_FALSE;
+
+static char const *B_BATCH_MANIFEST = NULL;
+static char const *B_INPUT_MANIFEST = NULL;
+static size_t B_NUMBER_OF_WORKERS = 0;
+
+static int B_SHOULD_READ_FROM_STDIN = B_FALSE;
+static char const *B_INPUT_FILENAME = NULL;
+
+static char const *B_PROGRAM_INPUT_FILENAME = NULL;
+
+static int B_SHOULD_EMIT_C_CODE = B_FALSE;
+static char const *B_C_CODE_FILENAME = "brainfuck.c";
+
+static int B_SHOULD_EMIT_LLVM_IR = B_FALSE;
+static char const *B_LLVM_IR_FILENAME = "brainfuck.l";
+
+static int B_SHOULD_EMIT_EXECUTABLE = B_FALSE;
+static char const *B_EXECUTABLE_FILENAME = "a.out";
+
+static int B_SHOULD_PRINT_BYTECODE_DISASSEMBLY = B_FALSE;
+static int B_SHOULD_EXPLAIN_CODE = B_FALSE;
+static int B_SHOULD_INTERPRET_CODE = B_TRUE;
+static int B_SHOULD_PRINT_STATISTICS = B_FALSE;
+static int B_SHOULD_PROFILE = B_FALSE;
+
+/* What the I/O callbacks read from and write to. */
+struct descriptors {
+    int input;
+    int output;
+};
+
+static inline double get_time(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static void display_help_screen(void)
+{
+    printf(
+        "    dP                         oo          .8888b             "
+        "      dP\n    88                                     88   \" "
+        "                  88\n    88d888b. 88d888b. .d8888b. dP 88d88"
+        "8b. 88aaa  dP    dP .d8888b. 88  .dP\n    88'  `88 88'  `88 8"
+        "8'  `88 88 88'  `88 88     88    88 88'  `\"\" 88888\"\n    8"
+        "8.  .88 88       88.  .88 88 88    88 88     88.  .88 88.  .."
+        ". 88  `8b.\n    88Y8888' dP       `88888P8 dP dP    dP dP    "
+        " `88888P' `88888P' dP   `YP\n"
+        "\n"
+        "Authored in 2013.  See README for a list of contributors.\n"
+        "Released into the public domain.\n"
+        "\n"
+        "Usage:\n"
+        "        %s [--abcdeEfghijklmnoOpqrsTtuvwxyz] <input>\n"
+        "\n"
+        "Options:\n"
+        "        --                          read input from stdin\n"
+        "        -a <manifest>               run the program over the inputs "
+        "of a manifest\n"
+        "        -b <manifest>               run the programs of a manifest in "
+        "parallel\n"
+        "        -c [filename=`brainfuck.c`] generate and emit C "
+        "code\n"
+        "        -d                          print disassembly\n"
+        "        -e                          explain source code\n"
+        "        -E                          disable evaluation ahead of "
+        "time\n"
+        "        -f <filename>               read program input from a "
+        "file\n"
+        "        -g <threads>                set the number of threads for "
+        "`-a` and `-b`\n"
+        "        -h                          display this help "
+        "screen\n"
+        "        -i <engine=`compact`>       select interpreter engine "
+        "(`switch`, `threaded`,\n"
+        "                                    `compact`, `tiered`)\n"
+        "        -j                          JIT compile to x86-64 without "
+        "LLVM and execute\n"
+        "        -k <directory>              cache JIT'd code in a directory\n"
+        "        -l [filename=`brainfuck.l`] generate and emit LLVM "
+        "IR\n"
+        "        -m <steps>                  limit the steps of the `switch` "
+        "engine\n"
+        "        -n <eof=`-1`>               set end of input value (`-1`, "
+        "`0`, `keep`)\n"
+        "        -o [filename=`a.out`]       compile to a native executable "
+        "(or `.o` object)\n"
+        "        -O <level=`3`>              set LLVM optimization level (`0` "
+        "to `3`)\n"
+        "        -p                          profile the interpreter and "
+        "report hot spots\n"
+        "        -q <milliseconds>           limit the running time\n"
+        "        -r                          JIT compile and execute\n"
+        "        -s                          print statistics\n"
+        "        -T <mebibytes>              limit the tape a run may use\n"
+        "        -t                          back the tape with huge pages\n"
+        "        -u                          disable optimizations\n"
+        "        -v                          display version "
+        "information\n"
+        "        -w <width=`8`>              set cell width in bits (`8`, `16`, "
+        "`32`, `64`)\n"
+        "        -x                          disable interpretation\n"
+        "        -y                          check tape bounds for untrusted "
+        "programs\n"
+        "        -z <length=`30000`>         set initial tape length\n",
+        B_INVOCATION);
+}
+
+static void parse_command_line(int count, char **arguments)
+{
+    int i = 1;
+
+    for (; i < count; ++i) {
+        switch (arguments[i][0]) {
+        case '-':
+            switch (arguments[i][1]) {
+            case '-':
+                B_SHOULD_READ_FROM_STDIN = B_TRUE;
+                break;
+
+            case 'a':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `a` requires "
+                        "a manifest\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_INPUT_MANIFEST = arguments[++i];
+                break;
+
+            case 'b':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `b` requires "
+                        "a manifest\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_BATCH_MANIFEST = arguments[++i];
+                break;
+
+            case 'c':
+                B_SHOULD_EMIT_C_CODE = B_TRUE;
+
+                if (i + 1 < count) {
+                    if (arguments[i + 1][0] != '\0') {
+                        B_C_CODE_FILENAME = arguments[++i];
+                    }
+                }
+                break;
+
+            case 'd':
+                B_SHOULD_PRINT_BYTECODE_DISASSEMBLY = B_TRUE;
+                break;
+
+            case 'e':
+                B_SHOULD_EXPLAIN_CODE = B_TRUE;
+                break;
+
+            case 'E':
+                B_OPTIONS.evaluation_budget = 0;
+                break;
+
+            case 'f':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `f` requires "
+                        "a filename\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_PROGRAM_INPUT_FILENAME = arguments[++i];
+                break;
+
+            case 'g':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `g` requires "
+                        "a numerical parameter\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_NUMBER_OF_WORKERS = strtoul(arguments[++i], NULL, 10);
+
+                if (B_NUMBER_OF_WORKERS == 0) {
+                    printf(
+                        "%s: the number of threads cannot be "
+                        "alphanumerical or zero\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                break;
+
+            case 'h':
+                display_help_screen();
+                break;
+
+            case 'i':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `i` requires "
+                        "an engine name\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                ++i;
+                B_HAS_ENGINE = B_TRUE;
+
+                if (strcmp(arguments[i], "switch") == 0) {
+                    B_ENGINE = B_SWITCH_ENGINE;
+                } else if (strcmp(arguments[i], "threaded") == 0) {
+                    B_ENGINE = B_THREADED_ENGINE;
+                } else if (strcmp(arguments[i], "compact") == 0) {
+                    B_ENGINE = B_COMPACT_ENGINE;
+                } else if (strcmp(arguments[i], "tiered") == 0) {
+                    B_ENGINE = B_TIERED_ENGINE;
+                } else {
+                    printf("%s: unknown engine `%s`\n", B_INVOCATION,
+                        arguments[i]);
+                    abort();
+                }
+
+                break;
+
+            case 'j':
+                B_OPTIONS.should_assemble = B_TRUE;
+                break;
+
+            case 'k':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `k` requires "
+                        "a directory\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_OPTIONS.cache_directory = arguments[++i];
+                break;
+
+            case 'l':
+                B_SHOULD_EMIT_LLVM_IR = B_TRUE;
+
+                if (i + 1 < count) {
+                    if (arguments[i + 1][0] != '\0') {
+                        B_LLVM_IR_FILENAME = arguments[++i];
+                    }
+                }
+                break;
+
+            case 'm':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `m` requires "
+                        "a numerical parameter\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_LIMITS.step_limit = strtoull(arguments[++i], NULL, 10);
+
+                if (B_LIMITS.step_limit == 0) {
+                    printf(
+                        "%s: the step limit cannot be "
+                        "alphanumerical or zero\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                break;
+
+            case 'n':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `n` requires "
+                        "an end of input value\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                ++i;
+
+                if (strcmp(arguments[i], "-1") == 0) {
+                    B_OPTIONS.end_of_input_value = -1;
+                } else if (strcmp(arguments[i], "0") == 0) {
+                    B_OPTIONS.end_of_input_value = 0;
+                } else if (strcmp(arguments[i], "keep") == 0) {
+                    B_OPTIONS.should_keep_cell_at_end_of_input = B_TRUE;
+                } else {
+                    printf("%s: unknown end of input value `%s`\n",
+                        B_INVOCATION, arguments[i]);
+                    abort();
+                }
+
+                break;
+
+            case 'O':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `O` requires "
+                        "a numerical parameter\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_OPTIONS.optimization_level = atoi(arguments[++i]);
+
+                if (B_OPTIONS.optimization_level < 0 ||
+                    B_OPTIONS.optimization_level > 3) {
+                    printf("%s: unsupported optimization level `%s`\n",
+                        B_INVOCATION, arguments[i]);
+                    abort();
+                }
+
+                break;
+
+            case 'o':
+                B_SHOULD_EMIT_EXECUTABLE = B_TRUE;
+
+                if (i + 1 < count) {
+                    if (arguments[i + 1][0] != '\0') {
+                        B_EXECUTABLE_FILENAME = arguments[++i];
+                    }
+                }
+                break;
+
+            case 'p':
+                B_SHOULD_PROFILE = B_TRUE;
+
+                /* The profile is of the whole program, as written. */
+                B_OPTIONS.evaluation_budget = 0;
+                break;
+
+            case 'q':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `q` requires "
+                        "a numerical parameter\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_LIMITS.time_limit = atof(arguments[++i]) / 1e3;
+
+                if (B_LIMITS.time_limit <= 0) {
+                    printf(
+                        "%s: the time limit cannot be "
+                        "alphanumerical or zero\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                break;
+
+            case 'r':
+                B_OPTIONS.should_compile = B_TRUE;
+                break;
+
+            case 's':
+                B_SHOULD_PRINT_STATISTICS = B_TRUE;
+                break;
+
+            case 'T':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `T` requires "
+                        "a numerical parameter\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_LIMITS.tape_limit = strtoul(arguments[++i], NULL, 10) << 20;
+
+                if (B_LIMITS.tape_limit == 0) {
+                    printf(
+                        "%s: the tape limit cannot be "
+                        "alphanumerical or zero\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                break;
+
+            case 't':
+                B_OPTIONS.should_use_huge_pages = B_TRUE;
+                break;
+
+            case 'u':
+                B_OPTIONS.should_optimize = B_FALSE;
+                break;
+
+            case 'v':
+                printf("%s (brainfuck) %s (%s)\n", B_INVOCATION,
+                    B_VERSION_STRING, B_BUILD_FEATURES);
+                break;
+
+            case 'w':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `w` requires "
+                        "a numerical parameter\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_OPTIONS.cell_width = atoi(arguments[++i]);
+
+                if (B_OPTIONS.cell_width != 8 && B_OPTIONS.cell_width != 16 &&
+                    B_OPTIONS.cell_width != 32 && B_OPTIONS.cell_width != 64) {
+                    printf("%s: unsupported cell width `%s`\n", B_INVOCATION,
+                        arguments[i]);
+                    abort();
+                }
+
+                break;
+
+            case 'x':
+                B_SHOULD_INTERPRET_CODE = B_FALSE;
+                break;
+
+            case 'y':
+                B_OPTIONS.should_check_tape = B_TRUE;
+                break;
+
+            case 'z':
+                if (i + 1 >= count) {
+                    printf(
+                        "%s: the argument `z` requires "
+                        "a numerical parameter\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                B_OPTIONS.container_length = atoi(arguments[++i]);
+
+                if (B_OPTIONS.container_length == 0) {
+                    printf(
+                        "%s: the tape length cannot be "
+                        "alphanumerical or zero\n",
+                        B_INVOCATION);
+                    abort();
+                }
+
+                break;
+
+            default:
+                printf(
+                    "%s: unknown option `%c`\n", B_INVOCATION, arguments[i][1]);
+            }
+
+            break;
+
+        default:
+            if (B_INPUT_FILENAME != NULL) {
+                printf(
+                    "%s: warning, overriding previously "
+                    "specified filename\n",
+                    B_INVOCATION);
+            }
+
+            B_INPUT_FILENAME = arguments[i];
+        }
+    }
+
+    /* Only the switch engine counts its steps, so neither JIT takes a step
+     * limit. */
+    if (B_LIMITS.step_limit != 0 &&
+        (B_OPTIONS.should_compile == B_TRUE ||
+            B_OPTIONS.should_assemble == B_TRUE)) {
+        printf("%s: the step limit cannot be combined with `r` or `j`\n",
+            B_INVOCATION);
+        abort();
+    }
+
+    if (B_LIMITS.step_limit != 0 && B_HAS_ENGINE == B_TRUE &&
+        B_ENGINE != B_SWITCH_ENGINE) {
+        printf("%s: the step limit requires the `switch` engine\n",
+            B_INVOCATION);
+        abort();
+    }
+
+    /* Without an engine of its own choosing, a step limit picks the one
+     * that counts its steps. */
+    if (B_LIMITS.step_limit != 0) {
+        B_ENGINE = B_SWITCH_ENGINE;
+    }
+}
+
+void respond_to_signal(int signal_identifier)
+{
+    (void) signal_identifier;
+
+    printf("%s: aborting\n", B_INVOCATION);
+    exit(EXIT_FAILURE);
+}
+
+static void fail(char const *what, enum brainfuck_status status)
+{
+    printf("%s: %s: %s\n", B_INVOCATION, what,
+        brainfuck_describe_status(status));
+    exit(EXIT_FAILURE);
+}
+
+static ssize_t read_descriptor(
+    void *context, unsigned char *buffer, size_t length)
+{
+    struct descriptors const *descriptors = context;
+    ssize_t result = 0;
+
+    do {
+        result = read(descriptors->input, buffer, length);
+    } while (result == -1 && errno == EINTR);
+
+    return result;
+}
+
+static int write_descriptor(
+    void *context, unsigned char const *buffer, size_t length)
+{
+    struct descriptors const *descriptors = context;
+
+    while (length != 0) {
+        ssize_t result = write(descriptors->output, buffer, length);
+
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+
+        if (result <= 0) {
+            return -1;
+        }
+
+        buffer += result;
+        length -= result;
+    }
+
+    return 0;
+}
+
+/* A file given with `-f` is mapped and handed over whole, and its end is the
+ * end of the input.  Otherwise input comes from stdin as it arrives. */
+static void open_input(char const *filename, struct brainfuck_io *io)
+{
+    struct stat status;
+    void *contents = NULL;
+
+    int descriptor = open(filename, O_RDONLY);
+
+    if (descriptor == -1 || fstat(descriptor, &status) != 0) {
+        printf("%s: cannot open `%s`\n", B_INVOCATION, filename);
+        abort();
+    }
+
+    if (status.st_size != 0) {
+        contents =
+            mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+        if (contents == MAP_FAILED) {
+            printf("%s: cannot map `%s`\n", B_INVOCATION, filename);
+            abort();
+        }
+
+        madvise(contents, status.st_size, MADV_SEQUENTIAL);
+
+        io->input = contents;
+        io->input_length = status.st_size;
+    }
+
+    io->read = NULL;
+    close(descriptor);
+}
+
+static void print_statistics(struct brainfuck_program const *program)
+{
+    struct brainfuck_statistics statistics;
+
+    brainfuck_get_statistics(program, &statistics);
+
+    fprintf(stderr,
+        "%s: loaded %zd bytes into %zd opcodes in %.3f ms (%.1f MiB/s)\n",
+        B_INVOCATION, statistics.source_length, statistics.number_of_opcodes,
+        statistics.loading_time * 1e3,
+        (statistics.loading_time > 0)
+            ? statistics.source_length / statistics.loading_time / (1 << 20)
+            : 0.0);
+
+    if (B_OPTIONS.should_check_tape == B_TRUE) {
+        fprintf(stderr, "%s: placed %zu tape checks\n", B_INVOCATION,
+            statistics.number_of_tape_checks);
+    }
+
+    if (statistics.number_of_evaluated_opcodes != 0) {
+        fprintf(stderr,
+            "%s: evaluated %" PRIu64 " opcodes ahead into %zu bytes of "
+            "output in %.3f ms\n",
+            B_INVOCATION, statistics.number_of_evaluated_opcodes,
+            statistics.evaluated_output_length,
+            statistics.evaluation_time * 1e3);
+    }
+
+    if (B_OPTIONS.should_compile == B_TRUE) {
+        if (B_OPTIONS.cache_directory != NULL) {
+            fprintf(stderr, "%s: cache %s (%llu hits, %llu misses)\n",
+                B_INVOCATION, statistics.is_cached == B_TRUE ? "hit" : "miss",
+                statistics.cache_hits, statistics.cache_misses);
+        }
+
+        fprintf(stderr, "%s: compiled in %.3f ms at -O%d\n", B_INVOCATION,
+            statistics.compilation_time * 1e3, B_OPTIONS.optimization_level);
+    }
+
+    if (B_OPTIONS.should_assemble == B_TRUE) {
+        fprintf(stderr, "%s: assembled in %.3f ms\n", B_INVOCATION,
+            statistics.assembly_time * 1e3);
+    }
+}
+
+static void run(struct brainfuck_program const *program,
+    enum brainfuck_engine engine, struct brainfuck_tape *tape,
+    struct brainfuck_io const *io)
+{
+    struct brainfuck_run_statistics statistics;
+    enum brainfuck_status status =
+        brainfuck_run(program, engine, tape, io, &B_LIMITS, &statistics);
+
+    if (status != B_SUCCESS) {
+        fail("execution stopped", status);
+    }
+
+    if (B_SHOULD_PRINT_STATISTICS == B_FALSE) {
+        return;
+    }
+
+    if (engine == B_SWITCH_ENGINE) {
+        fprintf(stderr, "%s: executed %" PRIu64 " opcodes\n", B_INVOCATION,
+            statistics.number_of_executed_opcodes);
+    } else if (engine == B_TIERED_ENGINE) {
+        fprintf(stderr,
+            "%s: compiled %zu of %zu hot loops in %.3f ms at -O%d\n",
+            B_INVOCATION, statistics.number_of_compiled_loops,
+            statistics.number_of_hot_loops, statistics.compilation_time * 1e3,
+            B_OPTIONS.optimization_level);
+    }
+}
+
+/* Manifests run everything on one engine: the LLVM JIT with `-r`, the
+ * template JIT with `-j`, or else the interpreter. */
+static void prepare_batch(struct batch *batch)
+{
+    batch->invocation = B_INVOCATION;
+    batch->options = &B_OPTIONS;
+    batch->limits = &B_LIMITS;
+    batch->number_of_workers = B_NUMBER_OF_WORKERS;
+    batch->should_print_statistics = B_SHOULD_PRINT_STATISTICS;
+
+    if (B_OPTIONS.should_compile == B_TRUE) {
+        batch->engine = B_COMPILED_ENGINE;
+        B_OPTIONS.should_assemble = B_FALSE;
+    } else if (B_OPTIONS.should_assemble == B_TRUE) {
+        batch->engine = B_ASSEMBLED_ENGINE;
+    } else {
+        batch->engine = B_ENGINE;
+    }
+}
+
+static int finish_manifest(char const *manifest, long failures)
+{
+    if (failures == B_BATCH_OUT_OF_MEMORY) {
+        printf("%s: `%s`: %s\n", B_INVOCATION, manifest,
+            brainfuck_describe_status(B_OUT_OF_MEMORY));
+        abort();
+    } else if (failures < 0) {
+        printf("%s: cannot read `%s`\n", B_INVOCATION, manifest);
+        abort();
+    }
+
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int count, char **arguments)
+{
+    struct brainfuck_program *program = NULL;
+    struct brainfuck_tape *tape = NULL;
+
+    struct descriptors descriptors = {STDIN_FILENO, STDOUT_FILENO};
+    struct brainfuck_io io = {NULL, 0, read_descriptor, write_descriptor,
+        &descriptors};
+
+    struct batch batch;
+
+    enum brainfuck_status status = B_SUCCESS;
+    size_t position = 0;
+
+    signal(SIGABRT, respond_to_signal);
+    signal(SIGINT, respond_to_signal);
+
+    B_INVOCATION = arguments[0];
+    brainfuck_set_default_options(&B_OPTIONS);
+
+    if (count == 1) {
+        printf("%s: no input files\n", B_INVOCATION);
+        abort();
+    }
+
+    parse_command_line(count, arguments);
+
+    if (B_BATCH_MANIFEST != NULL || B_INPUT_MANIFEST != NULL) {
+        prepare_batch(&batch);
+    }
+
+    if (B_BATCH_MANIFEST != NULL) {
+        return finish_manifest(
+            B_BATCH_MANIFEST, run_batch(&batch, B_BATCH_MANIFEST));
+    }
+
+    status = brainfuck_compile_file(
+        (B_SHOULD_READ_FROM_STDIN == B_TRUE) ? NULL : B_INPUT_FILENAME,
+        &B_OPTIONS, &program, &position);
+
+    if (status == B_UNMATCHED_BRACKET) {
+        printf("%s: unmatched bracket @ %zd\n", B_INVOCATION, position);
+        abort();
+    } else if (status == B_NOTHING_TO_DO) {
+        printf("%s: nothing to do\n", B_INVOCATION);
+        abort();
+    } else if (status != B_SUCCESS) {
+        fail("cannot compile the program", status);
+    }
+
+    if (B_SHOULD_PRINT_STATISTICS == B_TRUE) {
+        print_statistics(program);
+    }
+
+    if (B_SHOULD_PRINT_BYTECODE_DISASSEMBLY == B_TRUE) {
+        brainfuck_disassemble(program, stdout);
+    }
+
+    if (B_SHOULD_EXPLAIN_CODE == B_TRUE) {
+        brainfuck_explain(program, stdout);
+    }
+
+    /* Program output goes straight to the descriptor from here on. */
+    fflush(stdout);
+
+    if (B_SHOULD_EMIT_C_CODE == B_TRUE &&
+        (status = brainfuck_emit_c_code(program, B_C_CODE_FILENAME)) !=
+            B_SUCCESS) {
+        fail(B_C_CODE_FILENAME, status);
+    }
+
+    if (B_SHOULD_EMIT_LLVM_IR == B_TRUE &&
+        (status = brainfuck_emit_llvm_ir(program, B_LLVM_IR_FILENAME)) !=
+            B_SUCCESS) {
+        fail(B_LLVM_IR_FILENAME, status);
+    }
+
+    if (B_SHOULD_EMIT_EXECUTABLE == B_TRUE) {
+        double start = get_time();
+
+        status = brainfuck_emit_executable(program, B_EXECUTABLE_FILENAME);
+
+        if (status != B_SUCCESS) {
+            fail(B_EXECUTABLE_FILENAME, status);
+        }
+
+        if (B_SHOULD_PRINT_STATISTICS == B_TRUE) {
+            fprintf(stderr, "%s: emitted `%s` in %.3f ms at -O%d\n",
+                B_INVOCATION, B_EXECUTABLE_FILENAME,
+                (get_time() - start) * 1e3, B_OPTIONS.optimization_level);
+        }
+    }
+
+    /* The program is compiled once and shared by every thread. */
+    if (B_INPUT_MANIFEST != NULL) {
+        long failures = run_inputs(&batch, program, B_INPUT_MANIFEST);
+
+        brainfuck_destroy_program(program);
+        return finish_manifest(B_INPUT_MANIFEST, failures);
+    }
+
+    if (B_PROGRAM_INPUT_FILENAME != NULL) {
+        open_input(B_PROGRAM_INPUT_FILENAME, &io);
+    }
+
+    status = brainfuck_create_tape(
+        B_OPTIONS.container_length * B_OPTIONS.cell_width / 8,
+        B_OPTIONS.should_use_huge_pages, &tape);
+
+    if (status != B_SUCCESS) {
+        fail("cannot create the tape", status);
+    }
+
+    if (B_OPTIONS.should_compile == B_TRUE) {
+        run(program, B_COMPILED_ENGINE, tape, &io);
+    }
+
+    if (B_OPTIONS.should_assemble == B_TRUE) {
+        run(program, B_ASSEMBLED_ENGINE, tape, &io);
+    }
+
+    if (B_SHOULD_INTERPRET_CODE == B_TRUE) {
+        if (B_SHOULD_PROFILE == B_FALSE) {
+            run(program, B_ENGINE, tape, &io);
+        } else if ((status = brainfuck_profile(
+                        program, tape, &io, &B_LIMITS, stderr)) != B_SUCCESS) {
+            fail("execution stopped", status);
+        }
+    }
+
+    brainfuck_destroy_tape(tape);
+    brainfuck_destroy_program(program);
+
+    return 0;
+}